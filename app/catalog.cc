@@ -0,0 +1,44 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include <catalog.hh>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+/// Write a catalog of free polyominoes.
+/// Usage: 4color-catalog FILE [MAX_SIZE]
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " FILE [MAX_SIZE]" << std::endl;
+        return 1;
+    }
+    try
+    {
+        write_catalog(argv[1], argc > 2 ? std::atoi(argv[2]) : max_catalog_size);
+        Catalog catalog(argv[1]);
+        for (auto n{1}; n <= catalog.max_size(); ++n)
+            std::cout << n << ": " << catalog.count(n) << std::endl;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include <arguments.hh>
+#include <color_search.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+/// Look for maps of figures in pieces that need five or more colors.
+/// Usage: 4color-colors TILES [BOX [COPIES [COLORS]]]
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 5)
+    {
+        std::cerr << "Usage: " << argv[0] << " TILES [BOX [COPIES [COLORS]]]" << std::endl;
+        return 1;
+    }
+    try
+    {
+        Color_Search_Options options;
+        // By default the box has room for the figure in one piece, up to the limit.
+        std::size_t const max_box{16};
+        options.tiles = parse_count(argv[1], 2, 64);
+        options.box = argc > 2 ? parse_count(argv[2], 1, max_box)
+                               : std::min(options.tiles + 1, max_box);
+        options.copies = argc > 3 ? parse_count(argv[3], 1, 64) : 4;
+        options.colors = argc > 4 ? parse_count(argv[4], 0, 65) : options.copies + 1;
+
+        // Show the first map found for each figure.
+        std::map<std::vector<Point<int>>, std::size_t> counts;
+        auto stats{find_colorful_maps([&](Layout const& layout) {
+            auto const& tiles{layout.figure.tiles()};
+            if (counts[{tiles.begin(), tiles.end()}]++ > 0)
+                return;
+            std::cout << "Figure:";
+            for (auto const& t : tiles)
+                std::cout << " (" << t.x << ", " << t.y << ')';
+            std::cout << std::endl;
+            for (auto const& place : layout.placements)
+            {
+                auto const& m{place.transform};
+                std::cout << "  Copy: [" << m.xx << ' ' << m.xy << "; " << m.yx << ' '
+                          << m.yy << "] + (" << place.offset.x << ", " << place.offset.y
+                          << ')' << std::endl;
+            }
+        }, options)};
+        std::cout << stats.solutions << " maps of " << counts.size() << " figures, "
+                  << stats.nodes << " placements tried" << std::endl;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
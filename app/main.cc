@@ -13,19 +13,61 @@
 // You should have received a copy of the GNU General Public License along with 4color.
 // If not, see <http://www.gnu.org/licenses/>.
 
+#include <arguments.hh>
+#include <figure_view.hh>
 #include <grid_map.hh>
 
 #include <gtkmm.h>
 
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+/// Usage: 4color [VIEWS]
 int main(int argc, char** argv)
 {
+    // The number of views is taken off the arguments before GTK sees them.
+    std::size_t num_views{4};
+    if (argc > 1)
+    {
+        try
+        {
+            num_views = parse_count(argv[1], 1, view_colors.size());
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl
+                      << "Usage: " << argv[0] << " [VIEWS]" << std::endl;
+            return 1;
+        }
+        argv[1] = argv[0];
+        ++argv;
+        --argc;
+    }
     auto app = Gtk::Application::create(argc, argv, "4color");
 
-    Gtk::Window window;
-    Grid_Map grid(16, 20);
-    window.add(grid);
-    window.resize(grid.width(), grid.height());
-    grid.show();
+    // Edits are saved here as they're made so they can be recovered after a crash. Search
+    // results are cached here too. Other numbers of views get their own files.
+    std::filesystem::path journal_dir{Glib::get_user_cache_dir()};
+    journal_dir /= "4color";
+    std::error_code error;
+    std::filesystem::create_directories(journal_dir, error);
+    auto suffix{num_views == 4 ? std::string{} : "-" + std::to_string(num_views)};
+
+    try
+    {
+        Gtk::Window window;
+        Grid_Map grid(16, 20, num_views, (journal_dir / ("journal" + suffix)).string(),
+                      (journal_dir / ("solutions" + suffix + ".cache")).string());
+        window.add(grid);
+        window.resize(grid.width(), grid.height());
+        grid.show();
 
-    return app->run(window);
+        return app->run(window);
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 }
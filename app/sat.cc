@@ -0,0 +1,71 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include <arguments.hh>
+#include <sat_map.hh>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+/// Look for a figure with a map, or write the problem for another SAT solver.
+/// Usage: 4color-sat TILES [BOX [DIMACS_FILE]]
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " TILES [BOX [DIMACS_FILE]]" << std::endl;
+        return 1;
+    }
+    try
+    {
+        Sat_Map_Options options;
+        options.tiles = parse_count(argv[1], 1, 64);
+        options.box = argc > 2 ? parse_count(argv[2], 0, 64) : 0;
+        if (argc > 3)
+        {
+            std::ofstream os{argv[3]};
+            write_dimacs(os, encode_map(options).cnf);
+            if (!os)
+                throw std::runtime_error(std::string{"Can't write "} + argv[3]);
+            return 0;
+        }
+
+        auto result{find_map_sat(options)};
+        std::cout << result.stats.nodes << " conflicts" << std::endl;
+        if (!result.layout)
+        {
+            std::cout << "No map" << std::endl;
+            return 0;
+        }
+        std::cout << "Figure:";
+        for (auto const& t : result.layout->figure.tiles())
+            std::cout << " (" << t.x << ", " << t.y << ')';
+        std::cout << std::endl;
+        for (auto const& place : result.layout->placements)
+        {
+            auto const& m{place.transform};
+            std::cout << "Copy: [" << m.xx << ' ' << m.xy << "; " << m.yx << ' ' << m.yy
+                      << "] + (" << place.offset.x << ", " << place.offset.y << ')'
+                      << std::endl;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
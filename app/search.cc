@@ -0,0 +1,70 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include <arguments.hh>
+#include <png_reader.hh>
+#include <region_graph.hh>
+#include <search.hh>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/// Count the maps of the figure in an image by the number of colors they need.
+/// Usage: 4color-search IMAGE [COPIES [MIN_COLORS]]
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " IMAGE [COPIES [MIN_COLORS]]" << std::endl;
+        return 1;
+    }
+    try
+    {
+        auto figure{read_png(argv[1]).figure};
+        Search_Options options;
+        options.copies = argc > 2 ? parse_count(argv[2], 1, 64) : 4;
+        options.min_colors = argc > 3 ? parse_count(argv[3], 0, 65) : 0;
+
+        // Each thread keeps its own tally of maps by the number of colors.
+        std::vector<std::vector<std::size_t>> tallies(search_threads(options));
+        auto stats{find_maps(figure, [&](unsigned thread, Solution const& solution) {
+            auto colors{chromatic_number(region_graph(figure, solution))};
+            auto& tally{tallies[thread]};
+            if (tally.size() <= colors)
+                tally.resize(colors + 1);
+            ++tally[colors];
+        }, options)};
+
+        std::vector<std::size_t> total;
+        for (auto const& tally : tallies)
+        {
+            total.resize(std::max(total.size(), tally.size()));
+            for (std::size_t c{0}; c < tally.size(); ++c)
+                total[c] += tally[c];
+        }
+        std::cout << stats.solutions << " maps of " << options.copies << " copies"
+                  << std::endl;
+        for (std::size_t c{0}; c < total.size(); ++c)
+            if (total[c] > 0)
+                std::cout << c << " colors: " << total[c] << std::endl;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "arguments.hh"
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+std::size_t parse_count(char const* arg, std::size_t low, std::size_t high)
+{
+    std::size_t count{0};
+    auto end{arg + std::strlen(arg)};
+    auto [ptr, error]{std::from_chars(arg, end, count)};
+    if (error != std::errc{} || ptr != end || ptr == arg || count < low || count > high)
+        throw std::runtime_error("Expected a number from " + std::to_string(low) + " to "
+                                 + std::to_string(high) + ": " + arg);
+    return count;
+}
@@ -0,0 +1,25 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_ARGUMENTS_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_ARGUMENTS_HH_INCLUDED
+
+#include <cstddef>
+
+/// @return The count given by a command-line argument.
+/// @throw std::runtime_error if @p arg isn't a decimal number from @p low to @p high.
+std::size_t parse_count(char const* arg, std::size_t low, std::size_t high);
+
+#endif // FOUR_COLOR_LIB4COLOR_ARGUMENTS_HH_INCLUDED
@@ -0,0 +1,238 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "bitboard.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <numeric>
+
+constexpr int word_bits{64};
+
+Bitboard::Bitboard(int width, int height)
+    : m_width{width},
+      m_height{height},
+      m_words{(width + word_bits - 1)/word_bits},
+      m_bits(static_cast<std::size_t>(m_words)*height, 0)
+{
+}
+
+int Bitboard::width() const
+{
+    return m_width;
+}
+
+int Bitboard::height() const
+{
+    return m_height;
+}
+
+std::uint64_t* Bitboard::row(int y)
+{
+    return m_bits.data() + static_cast<std::size_t>(y)*m_words;
+}
+
+std::uint64_t const* Bitboard::row(int y) const
+{
+    return m_bits.data() + static_cast<std::size_t>(y)*m_words;
+}
+
+void Bitboard::set(Point<int> p)
+{
+    if (p.x >= 0 && p.x < m_width && p.y >= 0 && p.y < m_height)
+        row(p.y)[p.x/word_bits] |= std::uint64_t{1} << (p.x % word_bits);
+}
+
+bool Bitboard::test(Point<int> p) const
+{
+    return p.x >= 0 && p.x < m_width && p.y >= 0 && p.y < m_height
+        && (row(p.y)[p.x/word_bits] >> (p.x % word_bits) & 1) != 0;
+}
+
+bool Bitboard::empty() const
+{
+    return std::all_of(m_bits.begin(), m_bits.end(), [](auto w) { return w == 0; });
+}
+
+std::size_t Bitboard::count() const
+{
+    return std::accumulate(m_bits.begin(), m_bits.end(), std::size_t{0},
+                           [](auto n, auto w) { return n + std::popcount(w); });
+}
+
+bool Bitboard::intersects(Bitboard const& other) const
+{
+    assert(m_bits.size() == other.m_bits.size());
+    for (std::size_t i{0}; i < m_bits.size(); ++i)
+        if ((m_bits[i] & other.m_bits[i]) != 0)
+            return true;
+    return false;
+}
+
+Bitboard Bitboard::halo() const
+{
+    Bitboard out(m_width, m_height);
+    for (auto y{0}; y < m_height; ++y)
+    {
+        auto in{row(y)};
+        auto o{out.row(y)};
+        for (auto i{0}; i < m_words; ++i)
+        {
+            // Shift left and right, carrying bits between words.
+            auto carry_up{i > 0 ? in[i - 1] >> (word_bits - 1) : 0};
+            auto carry_down{i + 1 < m_words ? in[i + 1] << (word_bits - 1) : 0};
+            o[i] = (in[i] << 1 | carry_up) | (in[i] >> 1 | carry_down);
+            if (y > 0)
+                o[i] |= row(y - 1)[i];
+            if (y + 1 < m_height)
+                o[i] |= row(y + 1)[i];
+            o[i] &= ~in[i];
+        }
+    }
+    out.trim();
+    return out;
+}
+
+std::size_t Bitboard::shared_edges(Bitboard const& other) const
+{
+    assert(m_bits.size() == other.m_bits.size());
+    std::size_t edges{0};
+    for (auto y{0}; y < m_height; ++y)
+    {
+        auto a{row(y)};
+        auto b{other.row(y)};
+        for (auto i{0}; i < m_words; ++i)
+        {
+            // The other board's cells to the left and right, carrying bits between
+            // words as in halo().
+            auto carry_up{i > 0 ? b[i - 1] >> (word_bits - 1) : 0};
+            auto carry_down{i + 1 < m_words ? b[i + 1] << (word_bits - 1) : 0};
+            edges += std::popcount(a[i] & (b[i] << 1 | carry_up));
+            edges += std::popcount(a[i] & (b[i] >> 1 | carry_down));
+            if (y + 1 < m_height)
+                edges += std::popcount(a[i] & other.row(y + 1)[i]);
+            if (y > 0)
+                edges += std::popcount(a[i] & other.row(y - 1)[i]);
+        }
+    }
+    return edges;
+}
+
+Bitboard& Bitboard::invert()
+{
+    for (auto& w : m_bits)
+        w = ~w;
+    trim();
+    return *this;
+}
+
+void Bitboard::trim()
+{
+    if (m_width % word_bits == 0)
+        return;
+    auto mask{(std::uint64_t{1} << (m_width % word_bits)) - 1};
+    for (auto y{0}; y < m_height; ++y)
+        row(y)[m_words - 1] &= mask;
+}
+
+Bitboard& Bitboard::operator|=(Bitboard const& other)
+{
+    assert(m_bits.size() == other.m_bits.size());
+    for (std::size_t i{0}; i < m_bits.size(); ++i)
+        m_bits[i] |= other.m_bits[i];
+    return *this;
+}
+
+Bitboard& Bitboard::operator&=(Bitboard const& other)
+{
+    assert(m_bits.size() == other.m_bits.size());
+    for (std::size_t i{0}; i < m_bits.size(); ++i)
+        m_bits[i] &= other.m_bits[i];
+    return *this;
+}
+
+Bitboard operator|(Bitboard b1, Bitboard const& b2)
+{
+    return b1 |= b2;
+}
+
+Bitboard operator&(Bitboard b1, Bitboard const& b2)
+{
+    return b1 &= b2;
+}
+
+/// @return The root of a label in a union-find forest, compressing the path.
+int find_root(std::vector<int>& parents, int label)
+{
+    while (parents[label] != label)
+    {
+        parents[label] = parents[parents[label]];
+        label = parents[label];
+    }
+    return label;
+}
+
+Board_Pieces label_pieces(Bitboard const& board)
+{
+    auto const width{board.width()};
+    auto const area{static_cast<std::size_t>(width)*board.height()};
+    Board_Pieces result;
+    result.labels.assign(area, -1);
+    auto& labels{result.labels};
+
+    // First pass: give each set cell the label of the set cell to its left or below, and
+    // join the two labels when both are there.
+    std::vector<int> parents;
+    for (std::size_t i{0}; i < area; ++i)
+    {
+        auto x{static_cast<int>(i % width)};
+        auto y{static_cast<int>(i/width)};
+        if (!board.test({x, y}))
+            continue;
+        auto left{x > 0 ? labels[i - 1] : -1};
+        auto below{y > 0 ? labels[i - width] : -1};
+        if (left < 0 && below < 0)
+        {
+            labels[i] = parents.size();
+            parents.push_back(labels[i]);
+            continue;
+        }
+        labels[i] = left >= 0 ? left : below;
+        if (left >= 0 && below >= 0)
+        {
+            auto a{find_root(parents, left)};
+            auto b{find_root(parents, below)};
+            parents[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    // Second pass: number the pieces in the order of their first cells.
+    std::vector<int> piece(parents.size(), -1);
+    for (auto& label : labels)
+    {
+        if (label < 0)
+            continue;
+        auto root{find_root(parents, label)};
+        if (piece[root] < 0)
+        {
+            piece[root] = result.sizes.size();
+            result.sizes.push_back(0);
+        }
+        label = piece[root];
+        ++result.sizes[label];
+    }
+    return result;
+}
@@ -0,0 +1,90 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_BITBOARD_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_BITBOARD_HH_INCLUDED
+
+#include "point.hh"
+
+#include <cstdint>
+#include <vector>
+
+/// A rectangle of cells that are either set or not, stored one bit per cell. Used for
+/// testing overlap and contact of tile sets with word-wide operations instead of
+/// comparing tiles one at a time. Cell (0, 0) is the lower-left corner. Operations on
+/// two bitboards require them to have the same size.
+class Bitboard
+{
+public:
+    Bitboard(int width, int height);
+
+    int width() const;
+    int height() const;
+
+    /// Set a cell. Points outside of the board are ignored.
+    void set(Point<int> p);
+    /// @return True if the cell is set. False for points outside of the board.
+    bool test(Point<int> p) const;
+    /// @return True if no cells are set.
+    bool empty() const;
+    /// @return The number of set cells.
+    std::size_t count() const;
+    /// @return True if any cell is set in both boards.
+    bool intersects(Bitboard const& other) const;
+    /// @return The unset cells that share an edge with a set cell.
+    Bitboard halo() const;
+    /// @return The number of edges between a set cell of this board and a set cell of
+    /// @p other, counted with popcounts of shifted rows.
+    std::size_t shared_edges(Bitboard const& other) const;
+    /// Unset the set cells and set the unset ones.
+    Bitboard& invert();
+
+    Bitboard& operator|=(Bitboard const& other);
+    Bitboard& operator&=(Bitboard const& other);
+    bool operator==(Bitboard const& other) const = default;
+
+private:
+    /// @return A pointer to the first word of a row.
+    std::uint64_t* row(int y);
+    std::uint64_t const* row(int y) const;
+    /// Unset the bits past the right edge.
+    void trim();
+
+    int m_width;
+    int m_height;
+    /// The number of words in each row.
+    int m_words;
+    std::vector<std::uint64_t> m_bits;
+};
+
+Bitboard operator|(Bitboard b1, Bitboard const& b2);
+Bitboard operator&(Bitboard b1, Bitboard const& b2);
+
+/// The edge-connected pieces of a board's set cells.
+struct Board_Pieces
+{
+    /// The piece of each cell, row by row from the bottom, or -1 for an unset cell.
+    /// Pieces are numbered in the order of their first cells.
+    std::vector<int> labels;
+    /// The number of cells in each piece.
+    std::vector<std::size_t> sizes;
+};
+
+/// @return The pieces of a board's set cells. Each cell takes the label of the set cell
+/// to its left or below, and labels that meet are joined with union-find, so the time is
+/// linear in the area of the board.
+Board_Pieces label_pieces(Bitboard const& board);
+
+#endif // FOUR_COLOR_LIB4COLOR_BITBOARD_HH_INCLUDED
@@ -0,0 +1,362 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "catalog.hh"
+#include "layout.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static_assert(sizeof(Catalog_Header) == 40);
+static_assert(sizeof(Catalog_Section) == 32);
+static_assert(sizeof(Catalog_Slot) == 8);
+
+constexpr char catalog_magic[8]{'4', 'c', 'o', 'l', 'o', 'r', 'C', '\n'};
+constexpr std::uint32_t catalog_version{1};
+
+/// @return The number of bytes in a record for polyominoes of a size. The bounding box
+/// of an n-omino has width + height <= n + 1.
+std::size_t record_size(int size)
+{
+    auto area{((size + 1)/2)*((size + 2)/2)};
+    return 1 + (area + 7)/8;
+}
+
+/// Enumerates fixed polyominoes with Redelmeier's algorithm, keeping those in their
+/// least orientation, so each free polyomino is seen once.
+class Enumerator
+{
+public:
+    explicit Enumerator(int max_size)
+        : m_records(max_size + 1),
+          m_hashes(max_size + 1),
+          m_max_size{max_size},
+          m_stride{2*max_size + 1},
+          m_seen(static_cast<std::size_t>(m_stride)*(max_size + 1), false)
+    {
+    }
+
+    void run()
+    {
+        Untried untried;
+        untried.cells[untried.size++] = {0, 0};
+        m_seen[index({0, 0})] = true;
+        extend(untried);
+    }
+
+    /// The packed records of each size.
+    std::vector<std::string> m_records;
+    /// The canonical hashes of each size's records.
+    std::vector<std::vector<std::uint64_t>> m_hashes;
+
+private:
+    /// Each added tile puts at most 3 new cells in the untried set.
+    struct Untried
+    {
+        std::array<Point<int>, 3*max_catalog_size + 1> cells;
+        std::size_t size{0};
+    };
+
+    /// Cells below the origin's row or left of it in the same row are off limits, so that
+    /// each fixed polyomino has one position: the origin is its first tile.
+    bool allowed(Point<int> p) const
+    {
+        return p.y > 0 || (p.y == 0 && p.x >= 0);
+    }
+
+    std::size_t index(Point<int> p) const
+    {
+        return static_cast<std::size_t>(p.y)*m_stride + p.x + m_max_size;
+    }
+
+    void extend(Untried untried)
+    {
+        while (untried.size > 0)
+        {
+            auto cell{untried.cells[--untried.size]};
+            m_tiles.push_back(cell);
+            add();
+            if (static_cast<int>(m_tiles.size()) < m_max_size)
+            {
+                auto next{untried};
+                std::array<std::size_t, 4> marked;
+                std::size_t n_marked{0};
+                for (Point<int> d : {Point{1, 0}, Point{0, 1}, Point{-1, 0}, Point{0, -1}})
+                {
+                    auto p{cell + d};
+                    if (!allowed(p) || m_seen[index(p)])
+                        continue;
+                    m_seen[index(p)] = true;
+                    marked[n_marked++] = index(p);
+                    next.cells[next.size++] = p;
+                }
+                extend(next);
+                for (std::size_t i{0}; i < n_marked; ++i)
+                    m_seen[marked[i]] = false;
+            }
+            m_tiles.pop_back();
+        }
+    }
+
+    /// A bitmap of the tiles in an orientation, used only for comparing orientations.
+    using Key = std::array<std::uint64_t, 4>;
+
+    Key key(Matrix const& m) const
+    {
+        Placement place{m, {0, 0}};
+        Point<int> low{place(m_tiles.front())};
+        for (auto const& p : m_tiles)
+        {
+            auto q{place(p)};
+            low = {std::min(low.x, q.x), std::min(low.y, q.y)};
+        }
+        Key k{};
+        for (auto const& p : m_tiles)
+        {
+            auto q{place(p) - low};
+            auto bit{q.x*max_catalog_size + q.y};
+            k[bit/64] |= std::uint64_t{1} << (bit % 64);
+        }
+        return k;
+    }
+
+    /// Record the current polyomino if it's in its least orientation.
+    void add()
+    {
+        auto first{key(orientations.front())};
+        for (std::size_t i{1}; i < orientations.size(); ++i)
+            if (key(orientations[i]) < first)
+                return;
+
+        auto form{canonical_form(Figure{Tile_List{m_tiles.begin(), m_tiles.end()}})};
+        Point<int> size{0, 0};
+        for (auto const& p : form.tiles)
+            size = {std::max(size.x, p.x + 1), std::max(size.y, p.y + 1)};
+        auto n{form.tiles.size()};
+        std::string record(record_size(n), '\0');
+        record[0] = static_cast<char>((size.x - 1) | (size.y - 1) << 4);
+        for (auto const& p : form.tiles)
+        {
+            auto bit{p.x*size.y + p.y};
+            record[1 + bit/8] |= 1 << (bit % 8);
+        }
+        m_records[n] += record;
+        m_hashes[n].push_back(canonical_hash(form));
+    }
+
+    int m_max_size;
+    int m_stride;
+    std::vector<bool> m_seen;
+    std::vector<Point<int>> m_tiles;
+};
+
+/// Write the bytes of an array of records.
+template <typename T> void write_records(std::ostream& os, T const* records, std::size_t n)
+{
+    os.write(reinterpret_cast<char const*>(records), n*sizeof(T));
+}
+
+void write_catalog(std::string const& file, int max_size)
+{
+    if (max_size < 1 || max_size > max_catalog_size)
+        throw std::runtime_error("Catalog size must be from 1 to "
+                                 + std::to_string(max_catalog_size));
+    Enumerator shapes(max_size);
+    shapes.run();
+
+    Catalog_Header header{};
+    std::memcpy(header.magic, catalog_magic, sizeof(catalog_magic));
+    header.version = catalog_version;
+    header.max_size = max_size;
+    std::vector<Catalog_Section> sections(max_size + 1, Catalog_Section{});
+    std::uint64_t offset{sizeof(Catalog_Header) + sections.size()*sizeof(Catalog_Section)};
+    for (auto n{1}; n <= max_size; ++n)
+    {
+        auto count{shapes.m_hashes[n].size()};
+        sections[n] = {offset, header.num_shapes, count, record_size(n)};
+        offset += shapes.m_records[n].size();
+        header.num_shapes += count;
+    }
+    header.hash_slots = std::bit_ceil(2*header.num_shapes);
+    header.hash_offset = offset;
+
+    std::vector<Catalog_Slot> slots(header.hash_slots, Catalog_Slot{});
+    for (auto n{1}; n <= max_size; ++n)
+        for (std::size_t k{0}; k < sections[n].count; ++k)
+        {
+            auto hash{shapes.m_hashes[n][k]};
+            auto i{hash & (header.hash_slots - 1)};
+            while (slots[i].index != 0)
+                i = (i + 1) & (header.hash_slots - 1);
+            slots[i] = {static_cast<std::uint32_t>(sections[n].first + k + 1),
+                        static_cast<std::uint32_t>(hash >> 32)};
+        }
+
+    std::ofstream os{file, std::ios::binary | std::ios::trunc};
+    if (!os)
+        throw std::runtime_error("Can't open " + file + " for writing");
+    write_records(os, &header, 1);
+    write_records(os, sections.data(), sections.size());
+    for (auto n{1}; n <= max_size; ++n)
+        os.write(shapes.m_records[n].data(), shapes.m_records[n].size());
+    write_records(os, slots.data(), slots.size());
+    if (!os.flush())
+        throw std::runtime_error("Failed to write " + file);
+}
+
+Catalog::Catalog(std::string const& file)
+{
+    auto fd{::open(file.c_str(), O_RDONLY)};
+    if (fd < 0)
+        throw std::runtime_error("Can't open " + file);
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(Catalog_Header)))
+    {
+        m_size = info.st_size;
+        m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (m_data == nullptr || m_data == MAP_FAILED)
+    {
+        m_data = nullptr;
+        throw std::runtime_error(file + " is not a catalog file");
+    }
+
+    auto bytes{static_cast<char const*>(m_data)};
+    m_header = reinterpret_cast<Catalog_Header const*>(bytes);
+    auto const& h{*m_header};
+    auto sections_end{sizeof(Catalog_Header) + (h.max_size + 1)*sizeof(Catalog_Section)};
+    auto valid{std::memcmp(h.magic, catalog_magic, sizeof(catalog_magic)) == 0
+               && h.version == catalog_version
+               && h.max_size >= 1 && h.max_size <= max_catalog_size
+               && m_size >= sections_end
+               && std::has_single_bit(h.hash_slots)
+               && h.hash_offset <= m_size
+               && (m_size - h.hash_offset) == h.hash_slots*sizeof(Catalog_Slot)};
+    if (valid)
+    {
+        m_sections = reinterpret_cast<Catalog_Section const*>(bytes + sizeof(Catalog_Header));
+        m_slots = reinterpret_cast<Catalog_Slot const*>(bytes + h.hash_offset);
+        // Check the sections so that the accessors can't read outside the file.
+        std::uint64_t first{0};
+        for (std::size_t n{1}; valid && n <= h.max_size; ++n)
+        {
+            auto const& s{m_sections[n]};
+            valid = s.record_size == record_size(n)
+                && s.first == first
+                && s.offset >= sections_end
+                && s.offset + s.count*s.record_size <= h.hash_offset;
+            first += s.count;
+        }
+        valid = valid && first == h.num_shapes;
+    }
+    if (!valid)
+    {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        throw std::runtime_error(file + " is not a valid catalog file");
+    }
+    // Lookups jump around the file.
+    ::madvise(m_data, m_size, MADV_RANDOM);
+}
+
+Catalog::~Catalog()
+{
+    if (m_data)
+        ::munmap(m_data, m_size);
+}
+
+int Catalog::max_size() const
+{
+    return m_header->max_size;
+}
+
+std::size_t Catalog::count(int size) const
+{
+    return size >= 1 && size <= max_size() ? m_sections[size].count : 0;
+}
+
+unsigned char const* Catalog::record(int size, std::size_t k) const
+{
+    assert(k < count(size));
+    auto const& s{m_sections[size]};
+    return static_cast<unsigned char const*>(m_data) + s.offset + k*s.record_size;
+}
+
+std::vector<Point<int>> Catalog::tiles(int size, std::size_t k) const
+{
+    auto r{record(size, k)};
+    auto w{(r[0] & 0xf) + 1};
+    auto h{(r[0] >> 4) + 1};
+    std::vector<Point<int>> tiles;
+    tiles.reserve(size);
+    for (auto bit{0}; bit < w*h; ++bit)
+        if (r[1 + bit/8] >> (bit % 8) & 1)
+            tiles.push_back({bit/h, bit % h});
+    return tiles;
+}
+
+Figure Catalog::figure(int size, std::size_t k) const
+{
+    auto ts{tiles(size, k)};
+    return Figure{Tile_List{ts.begin(), ts.end()}};
+}
+
+Bitboard Catalog::bitboard(int size, std::size_t k) const
+{
+    auto r{record(size, k)};
+    auto w{(r[0] & 0xf) + 1};
+    auto h{(r[0] >> 4) + 1};
+    Bitboard board(w, h);
+    for (auto bit{0}; bit < w*h; ++bit)
+        if (r[1 + bit/8] >> (bit % 8) & 1)
+            board.set({bit/h, bit % h});
+    return board;
+}
+
+std::optional<std::size_t> Catalog::find(Figure const& figure) const
+{
+    int size = figure.tiles().size();
+    if (count(size) == 0)
+        return std::nullopt;
+    auto form{canonical_form(figure)};
+    auto hash{canonical_hash(form)};
+    auto mask{m_header->hash_slots - 1};
+    auto i{hash & mask};
+    for (std::size_t probe{0}; probe <= mask && m_slots[i].index != 0;
+         ++probe, i = (i + 1) & mask)
+    {
+        if (m_slots[i].tag != static_cast<std::uint32_t>(hash >> 32))
+            continue;
+        auto index{m_slots[i].index - 1};
+        auto const& s{m_sections[size]};
+        if (index < s.first || index >= s.first + s.count)
+            continue;
+        if (tiles(size, index - s.first) == form.tiles)
+            return index - s.first;
+    }
+    return std::nullopt;
+}
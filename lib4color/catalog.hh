@@ -0,0 +1,120 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_CATALOG_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_CATALOG_HH_INCLUDED
+
+#include "bitboard.hh"
+#include "figure.hh"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A catalog file holds every free polyomino (distinct under rotation, reflection, and
+// translation) up to a maximum size, each in its canonical orientation. Shapes are
+// grouped by size in fixed-width records, so shape k of size n is found by arithmetic.
+// A hash table of canonical hashes finds a shape's index. Everything is native-endian so
+// a mapped file can be read in place.
+//
+//   Catalog_Header
+//   Catalog_Section[max_size + 1]  Index 0 is unused.
+//   Records for size 1, then size 2,...
+//   Catalog_Slot[hash_slots]       Open addressing with linear probing.
+//
+// A record's first byte holds width - 1 in the low nibble and height - 1 in the high.
+// The rest is a bitmap of the bounding box, bit x*height + y for tile (x, y), so tiles
+// come out in ascending order.
+
+/// The largest polyomino a catalog can hold.
+constexpr int max_catalog_size{16};
+
+struct Catalog_Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t max_size;
+    std::uint64_t num_shapes;
+    std::uint64_t hash_slots;
+    /// The position of the hash table in the file.
+    std::uint64_t hash_offset;
+};
+
+/// The location of the records for one size.
+struct Catalog_Section
+{
+    /// The position of the first record in the file.
+    std::uint64_t offset;
+    /// The index of the first record among all sizes.
+    std::uint64_t first;
+    std::uint64_t count;
+    std::uint64_t record_size;
+};
+
+struct Catalog_Slot
+{
+    /// One more than the index of the shape among all sizes. Zero for an empty slot.
+    std::uint32_t index;
+    /// The high half of the canonical hash, for skipping most mismatches.
+    std::uint32_t tag;
+};
+
+/// Enumerate the free polyominoes up to a size and write them to a catalog file. This
+/// takes minutes for the largest size.
+/// @throw std::runtime_error if the size is out of range or the file can't be written.
+void write_catalog(std::string const& file, int max_size);
+
+/// A catalog file mapped into memory.
+class Catalog
+{
+public:
+    /// Map the file and check that its size and header are consistent.
+    /// @throw std::runtime_error if the file can't be read or isn't a catalog file.
+    explicit Catalog(std::string const& file);
+    Catalog(Catalog const&) = delete;
+    Catalog& operator=(Catalog const&) = delete;
+    ~Catalog();
+
+    /// @return The size of the largest polyominoes in the catalog.
+    int max_size() const;
+    /// @return The number of free polyominoes of a size. Zero if it's out of range.
+    std::size_t count(int size) const;
+
+    /// Shape @p k of a size. Tiles are in the canonical orientation with the bounding box
+    /// starting at (0, 0).
+    /// @{
+    std::vector<Point<int>> tiles(int size, std::size_t k) const;
+    Figure figure(int size, std::size_t k) const;
+    /// @return A board the size of the shape's bounding box.
+    Bitboard bitboard(int size, std::size_t k) const;
+    /// @}
+
+    /// @return The index of a shape among those of its size, or nothing if it's not in
+    /// the catalog.
+    std::optional<std::size_t> find(Figure const& figure) const;
+
+private:
+    /// @return A pointer to the start of a record.
+    unsigned char const* record(int size, std::size_t k) const;
+
+    void* m_data{nullptr};
+    std::size_t m_size{0};
+    Catalog_Header const* m_header{nullptr};
+    Catalog_Section const* m_sections{nullptr};
+    Catalog_Slot const* m_slots{nullptr};
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_CATALOG_HH_INCLUDED
@@ -0,0 +1,113 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "color_search.hh"
+#include "search.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+std::vector<Figure> scattered_figures(std::size_t tiles, int box)
+{
+    std::vector<Figure> figures;
+    if (box <= 0 || tiles < 2 || tiles > static_cast<std::size_t>(box*box))
+        return figures;
+
+    // Choose cells in increasing order. A shape that doesn't touch the bottom and left of
+    // the box is a translation of one that does, and one that's not in canonical form is
+    // a rotation or reflection of one that is.
+    std::vector<int> cells(tiles);
+    std::function<void(std::size_t, int)> choose{[&](std::size_t depth, int first) {
+        if (depth == tiles)
+        {
+            Tile_List chosen;
+            for (auto c : cells)
+                chosen.insert({c / box, c % box});
+            auto touches{[&chosen](auto on_edge) {
+                return std::any_of(chosen.begin(), chosen.end(), on_edge);
+            }};
+            if (!touches([](auto p) { return p.x == 0; })
+                || !touches([](auto p) { return p.y == 0; }))
+                return;
+            Figure figure{chosen};
+            if (!figure.is_contiguous() && canonical_form(figure).tiles
+                == std::vector<Point<int>>{chosen.begin(), chosen.end()})
+                figures.push_back(figure);
+            return;
+        }
+        for (auto c{first}; c < box*box; ++c)
+        {
+            cells[depth] = c;
+            choose(depth + 1, c + 1);
+        }
+    }};
+    choose(0, 0);
+    return figures;
+}
+
+Search_Stats find_colorful_maps(Layout_Handler const& handler,
+                                Color_Search_Options const& options)
+{
+    Search_Control control{options.limits};
+    auto figures{scattered_figures(options.tiles, options.box)};
+    if (!control.check())
+        return control.stats(0, 0.0);
+
+    // The figure searches stop when this search does.
+    std::stop_source stop;
+    std::stop_callback forward{options.limits.stop, [&stop] { stop.request_stop(); }};
+    Search_Options search;
+    search.copies = options.copies;
+    search.threads = 1;
+    search.limits = {stop.get_token(), options.limits.deadline};
+    search.min_colors = options.colors;
+
+    std::mutex mutex;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> found{0};
+    std::atomic<std::size_t> done{0};
+    auto work{[&] {
+        Search_Control::Counter counter;
+        for (auto i{next++}; i < figures.size() && !control.stopped(); i = next++)
+        {
+            auto const& figure{figures[i]};
+            auto stats{find_maps(figure, [&](unsigned, Solution const& solution) {
+                std::lock_guard lock{mutex};
+                ++found;
+                handler({figure, solution});
+            }, search)};
+            counter.unreported += stats.nodes;
+            if (!control.check(counter) || !stats.complete())
+            {
+                stop.request_stop();
+                break;
+            }
+            ++done;
+        }
+        control.flush(counter);
+    }};
+
+    {
+        std::vector<std::jthread> workers;
+        auto threads{default_threads(options.threads)};
+        for (auto t{0u}; t < threads; ++t)
+            workers.emplace_back(work);
+    }
+    return control.stats(found, figures.empty() ? 1.0
+                         : static_cast<double>(done)/figures.size());
+}
@@ -0,0 +1,56 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_COLOR_SEARCH_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_COLOR_SEARCH_HH_INCLUDED
+
+#include "joint_search.hh"
+#include "layout.hh"
+#include "search_control.hh"
+
+#include <vector>
+
+struct Color_Search_Options
+{
+    /// The number of tiles in each figure.
+    std::size_t tiles{2};
+    /// The figures are drawn in a square with sides of this many tiles.
+    int box{3};
+    /// The number of copies in a map. Each copy must share an edge with all the others.
+    std::size_t copies{4};
+    /// The fewest colors a map must need, counting the holes and the outside as regions.
+    std::size_t colors{5};
+    /// The number of worker threads. Zero for one per core.
+    unsigned threads{0};
+    /// When to end the search early. A node is a placement tried. The node budget is
+    /// checked between figures.
+    Search_Limits limits{};
+};
+
+/// @return The figures with a number of tiles in a box that are in more than one piece,
+/// one for each shape up to rotation, reflection, and translation. Each is in its
+/// canonical form.
+std::vector<Figure> scattered_figures(std::size_t tiles, int box);
+
+/// Find maps of figures in pieces that need at least options.colors colors. A figure in
+/// one piece makes a planar map, which never needs more than 4. The figures are handed
+/// out to the threads, and each is searched like find_maps() with the map's region graph
+/// colored exactly at the leaves. Each figure is tried once, and each of its maps is
+/// reported once. Calls to the handler are made one at a time.
+/// @return The statistics of the search. The fraction is the fraction of figures done.
+Search_Stats find_colorful_maps(Layout_Handler const& handler,
+                                Color_Search_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_COLOR_SEARCH_HH_INCLUDED
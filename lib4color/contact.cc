@@ -0,0 +1,61 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "contact.hh"
+#include "bitboard.hh"
+#include "layout.hh"
+
+#include <algorithm>
+
+Contact_Matrix contact_matrix(Figure const& figure, std::vector<Placement> const& placements)
+{
+    auto const k{placements.size()};
+    Contact_Matrix contacts(k, std::vector<std::size_t>(k, 0));
+    if (figure.tiles().empty() || k < 2)
+        return contacts;
+
+    auto box{bounds(figure, placements)};
+    std::vector<Bitboard> boards;
+    for (auto const& place : placements)
+    {
+        boards.emplace_back(box.width(), box.height());
+        for (auto const& tile : figure.tiles())
+            boards.back().set(place(tile) - box.low);
+    }
+    for (std::size_t i{0}; i < k; ++i)
+        for (auto j{i + 1}; j < k; ++j)
+            contacts[i][j] = contacts[j][i] = boards[i].shared_edges(boards[j]);
+    return contacts;
+}
+
+std::size_t weakest_contact(Contact_Matrix const& contacts)
+{
+    if (contacts.size() < 2)
+        return 0;
+    auto weakest{contacts[0][1]};
+    for (std::size_t i{0}; i < contacts.size(); ++i)
+        for (auto j{i + 1}; j < contacts.size(); ++j)
+            weakest = std::min(weakest, contacts[i][j]);
+    return weakest;
+}
+
+std::size_t total_contact(Contact_Matrix const& contacts)
+{
+    std::size_t total{0};
+    for (std::size_t i{0}; i < contacts.size(); ++i)
+        for (auto j{i + 1}; j < contacts.size(); ++j)
+            total += contacts[i][j];
+    return total;
+}
@@ -0,0 +1,40 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_CONTACT_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_CONTACT_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+
+#include <vector>
+
+/// The number of edges shared by each pair of copies. Element [i][j] is the count for
+/// copies i and j. The diagonal is zero.
+using Contact_Matrix = std::vector<std::vector<std::size_t>>;
+
+/// @return The contact matrix for copies of a figure. The copies are drawn on bitboards
+/// around the map, so the cost grows with the area of the map rather than the square
+/// of the number of tiles.
+Contact_Matrix contact_matrix(Figure const& figure, std::vector<Placement> const& placements);
+
+/// @return The fewest edges shared by any pair of copies, or 0 if there are fewer than 2
+/// copies.
+std::size_t weakest_contact(Contact_Matrix const& contacts);
+
+/// @return The total number of edges shared by copies.
+std::size_t total_contact(Contact_Matrix const& contacts);
+
+#endif // FOUR_COLOR_LIB4COLOR_CONTACT_HH_INCLUDED
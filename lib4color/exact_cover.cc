@@ -0,0 +1,294 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "exact_cover.hh"
+#include "bitboard.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <thread>
+
+/// A node of the dancing-links matrix. Nodes are kept in one array and linked by index,
+/// which keeps them close together in memory.
+struct Dlx_Node
+{
+    std::int32_t left;
+    std::int32_t right;
+    std::int32_t up;
+    std::int32_t down;
+    /// The column's header node.
+    std::int32_t column;
+    /// The row of a matrix node. -1 for headers.
+    std::int32_t row;
+};
+
+/// The sparse 0-1 matrix of an exact-cover problem with the links that let Algorithm X
+/// remove and restore columns and rows in place. Node 0 is the root and nodes 1 to the
+/// number of columns are the column headers.
+class Dancing_Links
+{
+public:
+    /// @param rows The columns set in each row, numbered from zero.
+    Dancing_Links(int columns, std::vector<std::vector<int>> const& rows)
+        : m_nodes(columns + 1),
+          m_sizes(columns + 1, 0)
+    {
+        for (std::int32_t c{0}; c <= columns; ++c)
+            m_nodes[c] = {c - 1, c + 1, c, c, c, -1};
+        m_nodes[0].left = columns;
+        m_nodes[columns].right = 0;
+
+        for (std::int32_t r{0}; r < static_cast<std::int32_t>(rows.size()); ++r)
+        {
+            std::int32_t first{-1};
+            for (auto c : rows[r])
+            {
+                auto h{c + 1};
+                auto n{static_cast<std::int32_t>(m_nodes.size())};
+                m_nodes.push_back({n, n, m_nodes[h].up, h, h, r});
+                m_nodes[m_nodes[h].up].down = n;
+                m_nodes[h].up = n;
+                ++m_sizes[h];
+                if (first < 0)
+                    first = n;
+                else
+                {
+                    // Put the node at the end of the row's ring.
+                    m_nodes[n].left = m_nodes[first].left;
+                    m_nodes[n].right = first;
+                    m_nodes[m_nodes[first].left].right = n;
+                    m_nodes[first].left = n;
+                }
+            }
+        }
+    }
+
+    /// @return The uncovered column with the fewest rows, or 0 if all are covered.
+    std::int32_t choose() const
+    {
+        std::int32_t best{0};
+        for (auto c{m_nodes[0].right}; c != 0; c = m_nodes[c].right)
+            if (best == 0 || m_sizes[c] < m_sizes[best])
+                best = c;
+        return best;
+    }
+    /// @return The matrix nodes in a column.
+    std::vector<std::int32_t> column_nodes(std::int32_t c) const
+    {
+        std::vector<std::int32_t> nodes;
+        for (auto n{m_nodes[c].down}; n != c; n = m_nodes[n].down)
+            nodes.push_back(n);
+        return nodes;
+    }
+    /// Remove a column and the rows that have it.
+    void cover(std::int32_t c)
+    {
+        m_nodes[m_nodes[c].right].left = m_nodes[c].left;
+        m_nodes[m_nodes[c].left].right = m_nodes[c].right;
+        for (auto i{m_nodes[c].down}; i != c; i = m_nodes[i].down)
+            for (auto j{m_nodes[i].right}; j != i; j = m_nodes[j].right)
+            {
+                m_nodes[m_nodes[j].down].up = m_nodes[j].up;
+                m_nodes[m_nodes[j].up].down = m_nodes[j].down;
+                --m_sizes[m_nodes[j].column];
+            }
+    }
+    /// Undo cover().
+    void uncover(std::int32_t c)
+    {
+        for (auto i{m_nodes[c].up}; i != c; i = m_nodes[i].up)
+            for (auto j{m_nodes[i].left}; j != i; j = m_nodes[j].left)
+            {
+                ++m_sizes[m_nodes[j].column];
+                m_nodes[m_nodes[j].down].up = j;
+                m_nodes[m_nodes[j].up].down = j;
+            }
+        m_nodes[m_nodes[c].right].left = c;
+        m_nodes[m_nodes[c].left].right = c;
+    }
+    /// Cover the other columns of the row of node @p n. Its own column must be covered.
+    void select(std::int32_t n)
+    {
+        for (auto j{m_nodes[n].right}; j != n; j = m_nodes[j].right)
+            cover(m_nodes[j].column);
+    }
+    /// Undo select().
+    void unselect(std::int32_t n)
+    {
+        for (auto j{m_nodes[n].left}; j != n; j = m_nodes[j].left)
+            uncover(m_nodes[j].column);
+    }
+    std::int32_t row(std::int32_t n) const
+    {
+        return m_nodes[n].row;
+    }
+
+    /// Find the exact covers of the columns that are left. @p found is called with the
+    /// rows chosen for each.
+    /// @return False if the search was stopped.
+    template <typename Found>
+    bool search(Search_Control& control, Search_Control::Counter& counter,
+                std::vector<std::int32_t>& chosen, Found const& found)
+    {
+        auto c{choose()};
+        if (c == 0)
+        {
+            found(chosen);
+            return true;
+        }
+        if (m_sizes[c] == 0)
+            return true;
+
+        cover(c);
+        auto go{true};
+        for (auto n{m_nodes[c].down}; go && n != c; n = m_nodes[n].down)
+        {
+            if (!control.visit(counter))
+            {
+                go = false;
+                break;
+            }
+            chosen.push_back(m_nodes[n].row);
+            select(n);
+            go = search(control, counter, chosen, found);
+            unselect(n);
+            chosen.pop_back();
+        }
+        uncover(c);
+        return go;
+    }
+
+private:
+    std::vector<Dlx_Node> m_nodes;
+    std::vector<std::int32_t> m_sizes;
+};
+
+Tile_List rectangle(Point<int> low, Point<int> high)
+{
+    Tile_List tiles;
+    for (auto x{low.x}; x <= high.x; ++x)
+        for (auto y{low.y}; y <= high.y; ++y)
+            tiles.insert({x, y});
+    return tiles;
+}
+
+Search_Stats find_covers(Figure const& figure,
+                         Tile_List const& region,
+                         Solution_Handler const& handler,
+                         Cover_Options const& options)
+{
+    Search_Control control{options.limits};
+    auto const& tiles{figure.tiles()};
+    if (tiles.empty() || region.empty() || region.size() % tiles.size() != 0)
+        return control.stats(0, 1.0);
+
+    // The columns are the region's tiles.
+    std::map<Point<int>, int> columns;
+    for (auto const& p : region)
+        columns.emplace(p, static_cast<int>(columns.size()));
+    auto box{bounds(region)};
+    auto origin{box.low - Point<int>{1, 1}};
+    auto size{box.high - box.low + Point<int>{3, 3}};
+
+    // The rows are the placements that fit in the region, one for each set of tiles
+    // covered. Put the figure's first tile on each of the region's tiles.
+    std::vector<Placement> placements;
+    std::vector<std::vector<int>> rows;
+    std::vector<Bitboard> boards;
+    std::set<std::vector<int>> seen;
+    for (auto const& m : orientations)
+        for (auto const& p : region)
+        {
+            Placement place{m, {0, 0}};
+            place.offset = p - place(*tiles.begin());
+            std::vector<int> row;
+            for (auto const& t : tiles)
+                if (auto it{columns.find(place(t))}; it != columns.end())
+                    row.push_back(it->second);
+            std::sort(row.begin(), row.end());
+            if (row.size() != tiles.size() || !seen.insert(row).second)
+                continue;
+            placements.push_back(place);
+            rows.push_back(std::move(row));
+            boards.emplace_back(size.x, size.y);
+            for (auto const& t : tiles)
+                boards.back().set(place(t) - origin);
+        }
+
+    Dancing_Links matrix(static_cast<int>(columns.size()), rows);
+    auto first{matrix.choose()};
+    auto starts{matrix.column_nodes(first)};
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> found{0};
+    std::atomic<std::size_t> done{0};
+
+    auto work{[&](unsigned thread) {
+        Search_Control::Counter counter;
+        // Each thread changes its own copy of the matrix.
+        auto links{matrix};
+        links.cover(first);
+        std::vector<std::int32_t> chosen;
+        Solution solution;
+        auto report{[&](std::vector<std::int32_t> const& cover) {
+            if (options.require_contacts)
+                for (std::size_t i{0}; i < cover.size(); ++i)
+                {
+                    auto halo{boards[cover[i]].halo()};
+                    for (auto j{i + 1}; j < cover.size(); ++j)
+                        if (!halo.intersects(boards[cover[j]]))
+                            return;
+                }
+            solution.clear();
+            for (auto r : cover)
+                solution.push_back(placements[r]);
+            ++found;
+            handler(thread, solution);
+        }};
+        try
+        {
+            for (auto i{next++}; i < starts.size() && !control.stopped(); i = next++)
+            {
+                if (!control.visit(counter))
+                    break;
+                chosen.assign(1, links.row(starts[i]));
+                links.select(starts[i]);
+                auto complete{links.search(control, counter, chosen, report)};
+                links.unselect(starts[i]);
+                if (!complete)
+                    break;
+                ++done;
+            }
+        }
+        catch (...)
+        {
+            // An exception would end the program if it left the thread.
+            control.fail(std::current_exception());
+        }
+        control.flush(counter);
+    }};
+
+    {
+        std::vector<std::jthread> workers;
+        auto threads{default_threads(options.threads)};
+        for (auto t{0u}; t < threads; ++t)
+            workers.emplace_back(work, t);
+    }
+    control.rethrow();
+    return control.stats(found, starts.empty() ? 1.0
+                         : static_cast<double>(done)/starts.size());
+}
@@ -0,0 +1,47 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_EXACT_COVER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_EXACT_COVER_HH_INCLUDED
+
+#include "figure.hh"
+#include "search.hh"
+#include "search_control.hh"
+
+struct Cover_Options
+{
+    /// The number of worker threads. Zero for one per core.
+    unsigned threads{0};
+    /// If true, report only covers where each copy shares an edge with all the others.
+    bool require_contacts{true};
+    /// When to end the search early. A node is a placement tried.
+    Search_Limits limits{};
+};
+
+/// Find all the ways to fill a region exactly with copies of a figure. The number of
+/// copies is the size of the region over the size of the figure. The search is Knuth's
+/// Algorithm X with dancing links, split across threads by the placement chosen for the
+/// region's most constrained tile. The placements are in the region's coordinates, so
+/// no copy is fixed.
+/// @return The statistics of the search, including the number of covers reported.
+Search_Stats find_covers(Figure const& figure,
+                         Tile_List const& region,
+                         Solution_Handler const& handler,
+                         Cover_Options const& options = {});
+
+/// @return The tiles of the rectangle with corners @p low and @p high inclusive.
+Tile_List rectangle(Point<int> low, Point<int> high);
+
+#endif // FOUR_COLOR_LIB4COLOR_EXACT_COVER_HH_INCLUDED
@@ -0,0 +1,93 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "export_queue.hh"
+
+#include <iostream>
+#include <stdexcept>
+
+Export_Queue::Export_Queue(std::function<void()> notify)
+    : m_notify{std::move(notify)},
+      m_worker{&Export_Queue::run, this}
+{
+}
+
+Export_Queue::~Export_Queue()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+void Export_Queue::push(Export_Job job)
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+std::size_t Export_Queue::pending() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_jobs.size() + (m_busy ? 1 : 0);
+}
+
+int Export_Queue::percent_done() const
+{
+    return m_percent;
+}
+
+void Export_Queue::run()
+{
+    while (true)
+    {
+        std::unique_lock lock{m_mutex};
+        m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        // Pending jobs are finished before stopping.
+        if (m_jobs.empty())
+            return;
+        auto const job{std::move(m_jobs.front())};
+        m_jobs.pop_front();
+        m_busy = true;
+        lock.unlock();
+
+        m_percent = 0;
+        auto progress = [this](double fraction) {
+            auto percent{static_cast<int>(100*fraction)};
+            if (m_percent.exchange(percent) != percent && m_notify)
+                m_notify();
+        };
+        try
+        {
+            write_png(job.file, job.layout.figure, job.layout.placements,
+                      job.frame, job.scale, progress);
+        }
+        catch (std::exception const& error)
+        {
+            std::cerr << error.what() << std::endl;
+        }
+
+        lock.lock();
+        m_busy = false;
+        lock.unlock();
+        if (m_notify)
+            m_notify();
+    }
+}
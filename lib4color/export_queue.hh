@@ -0,0 +1,74 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_EXPORT_QUEUE_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_EXPORT_QUEUE_HH_INCLUDED
+
+#include "layout.hh"
+#include "render.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// A request to write a PNG image of a layout.
+struct Export_Job
+{
+    std::string file;
+    Layout layout;
+    Frame frame;
+    double scale{1.0};
+};
+
+/// Writes PNG images on a background thread, one at a time in the order requested.
+/// Each job carries its own copy of the layout, so the caller may go on changing its
+/// figure while the image is written.
+class Export_Queue
+{
+public:
+    /// @param notify Called on the worker thread when the progress changes and when a job
+    /// finishes.
+    explicit Export_Queue(std::function<void()> notify = {});
+    /// Finish the pending jobs and stop the worker.
+    ~Export_Queue();
+
+    /// Add a job to the end of the queue.
+    void push(Export_Job job);
+    /// @return The number of jobs not finished, including the one in progress.
+    std::size_t pending() const;
+    /// @return The percentage of the current job that's been done.
+    int percent_done() const;
+
+private:
+    /// Do jobs until stopped.
+    void run();
+
+    std::function<void()> m_notify;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Export_Job> m_jobs;
+    /// True while the worker is writing an image.
+    bool m_busy{false};
+    bool m_stop{false};
+    std::atomic<int> m_percent{0};
+    /// The worker is started last and stopped first.
+    std::thread m_worker;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_EXPORT_QUEUE_HH_INCLUDED
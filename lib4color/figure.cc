@@ -14,17 +14,63 @@
 // If not, see <http://www.gnu.org/licenses/>.
 
 #include "figure.hh"
+#include "bitboard.hh"
 
-/// A recursive flood-fill algorithm to find adjacent tiles.
-void flood(Tile_List const& tiles, Tile_List& filled, Point<int> const& p)
+#include <algorithm>
+
+void Bounds::include(Point<int> p)
+{
+    low = {std::min(low.x, p.x), std::min(low.y, p.y)};
+    high = {std::max(high.x, p.x), std::max(high.y, p.y)};
+}
+
+int Bounds::width() const
+{
+    return high.x - low.x + 1;
+}
+
+int Bounds::height() const
+{
+    return high.y - low.y + 1;
+}
+
+std::size_t Bounds::area() const
+{
+    return static_cast<std::size_t>(width())*height();
+}
+
+Bounds Bounds::operator|(Bounds const& other) const
+{
+    auto both{*this};
+    both.include(other.low);
+    both.include(other.high);
+    return both;
+}
+
+Bounds bounds(Tile_List const& tiles)
 {
-    if (!tiles.contains(p) || filled.contains(p))
-        return;
-    filled.insert(p);
-    flood(tiles, filled, {p.x+1, p.y});
-    flood(tiles, filled, {p.x-1, p.y});
-    flood(tiles, filled, {p.x, p.y+1});
-    flood(tiles, filled, {p.x, p.y-1});
+    Bounds box{*tiles.begin(), *tiles.begin()};
+    for (auto const& t : tiles)
+        box.include(t);
+    return box;
+}
+
+std::vector<Tile_List> pieces(Tile_List const& tiles)
+{
+    if (tiles.empty())
+        return {};
+    auto box{bounds(tiles)};
+    Bitboard board(box.width(), box.height());
+    for (auto const& t : tiles)
+        board.set(t - box.low);
+    auto labeled{label_pieces(board)};
+    std::vector<Tile_List> result(labeled.sizes.size());
+    for (auto const& t : tiles)
+    {
+        auto p{t - box.low};
+        result[labeled.labels[static_cast<std::size_t>(p.y)*box.width() + p.x]].insert(t);
+    }
+    return result;
 }
 
 Figure::Figure()
@@ -37,12 +83,14 @@ Figure::Figure(std::initializer_list<Point<int>> ps)
         m_tiles.insert(p);
 }
 
+Figure::Figure(Tile_List tiles)
+    : m_tiles{std::move(tiles)}
+{
+}
+
 bool Figure::is_contiguous() const
 {
-    // The figure is contiguous if all tiles are filled.
-    Tile_List filled;
-    flood(m_tiles, filled, *m_tiles.begin());
-    return filled.size() == m_tiles.size();
+    return pieces(m_tiles).size() <= 1;
 }
 
 Tile_List const& Figure::tiles() const
@@ -20,15 +20,38 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
 
 using Tile_List = std::set<Point<int>>;
 
+/// The smallest rectangle that holds a set of tiles.
+struct Bounds
+{
+    Point<int> low;
+    Point<int> high;
+
+    /// Grow to hold a tile.
+    void include(Point<int> p);
+    int width() const;
+    int height() const;
+    std::size_t area() const;
+    /// @return The bounds that hold both.
+    Bounds operator|(Bounds const& other) const;
+};
+
+/// @return The bounds of a set of tiles, which must not be empty.
+Bounds bounds(Tile_List const& tiles);
+/// @return The edge-connected pieces of a set of tiles, found by labeling a bitboard of
+/// their bounds.
+std::vector<Tile_List> pieces(Tile_List const& tiles);
+
 /// A polyomino with tiles at integer coordinates.
 class Figure
 {
 public:
     Figure();
     Figure(std::initializer_list<Point<int>> ps);
+    explicit Figure(Tile_List tiles);
 
     /// @return True if each tile shares an edge with another.
     bool is_contiguous() const;
@@ -16,6 +16,7 @@
 #include "figure.hh"
 #include "figure_view.hh"
 
+#include <algorithm>
 #include <cassert>
 
 template <typename Container>
@@ -33,7 +34,6 @@ Matrix constexpr Rr{ 0,  1, -1,  0}; // Right (CW) rotation
 Matrix constexpr Fx{ 1,  0,  0, -1}; // Flip about x-axis
 Matrix constexpr Fy{-1,  0,  0,  1}; // Flip about y-axis
 
-/// Multiply transformation matrices.
 Matrix operator*(Matrix const& m1, Matrix const& m2)
 {
     return {m1.xx*m2.xx + m1.xy*m2.yx, m1.xx*m2.xy + m1.xy*m2.yy,
@@ -59,13 +59,30 @@ Point<T> operator*(Matrix const& m1, Point<T> const& p)
     return {m1.xx*p.x + m1.xy*p.y, m1.yx*p.x + m1.yy*p.y};
 }
 
-/// @return The transpose of a matrix - the inverse of a transformation matrix.
 Matrix transpose(Matrix const& m)
 {
     return {m.xx, m.yx,
             m.xy, m.yy};
 }
 
+std::size_t orientation_index(Matrix const& m)
+{
+    auto it{std::find(orientations.begin(), orientations.end(), m)};
+    assert(it != orientations.end());
+    return std::distance(orientations.begin(), it);
+}
+
+Placement operator*(Placement const& p1, Placement const& p2)
+{
+    return {p1.transform*p2.transform, p1(p2.offset)};
+}
+
+Placement inverse(Placement const& p)
+{
+    auto t{transpose(p.transform)};
+    return {t, -(t*p.offset)};
+}
+
 using VTiles = std::vector<Point<double>>;
 
 /// Change the tiles' positions.
@@ -107,25 +124,44 @@ Tile_List Figure_View::tiles() const
     if (m_figure.tiles().empty())
         return {};
 
-    VTiles tiles;
-    for (auto t : (m_figure.tiles()))
-        tiles.emplace_back(t.x, t.y);
-
-    auto r{cm(tiles)};
-    do_translate(-r, tiles);
-    transform(m_transform, tiles);
-    do_translate(r, tiles);
-    do_translate(m_dcm, tiles);
-    do_translate(m_dr, tiles);
-    auto p{to_double(flooround(tiles.front()))};
-    m_dr += p - tiles.front();
-
+    auto place{placement()};
     Tile_List rounded;
-    for (auto t : tiles)
-        rounded.insert(flooround(t));
+    for (auto t : m_figure.tiles())
+        rounded.insert(place(t));
     return rounded;
 }
 
+Placement Figure_View::placement() const
+{
+    if (m_figure.tiles().empty())
+        return {m_transform, {}};
+
+    // Only the first tile needs the floating-point transformation. The rest have the same
+    // offset from their untransformed positions.
+    auto front{*m_figure.tiles().begin()};
+    VTiles tile{to_double(front)};
+    auto r{cm(m_figure.tiles())};
+    do_translate(-r, tile);
+    transform(m_transform, tile);
+    do_translate(r, tile);
+    do_translate(m_dcm, tile);
+    do_translate(m_dr, tile);
+    auto p{flooround(tile.front())};
+    m_dr += to_double(p) - tile.front();
+
+    return {m_transform, p - m_transform*front};
+}
+
+Figure_View& Figure_View::place(Placement const& place)
+{
+    // Choose the translation so that T(t - r) + r + dr = T t + offset.
+    auto r{cm(m_figure.tiles())};
+    m_transform = place.transform;
+    m_dcm = {0.0, 0.0};
+    m_dr = to_double(place.offset) - r + m_transform*r;
+    return *this;
+}
+
 Figure_View& Figure_View::toggle(Point<int> p)
 {
     VTiles tiles;
@@ -16,6 +16,7 @@
 #ifndef FOUR_COLOR_LIB4COLOR_FIGURE_VIEW_HH_INCLUDED
 #define FOUR_COLOR_LIB4COLOR_FIGURE_VIEW_HH_INCLUDED
 
+#include <array>
 #include <iostream>
 #include <tuple>
 #include <vector>
@@ -32,15 +33,59 @@ constexpr Color red{277, 74, 51};
 constexpr Color yellow{254, 217, 142};
 constexpr Color green{44, 162, 95};
 constexpr Color blue{5, 112, 176};
+constexpr Color purple{117, 107, 177};
+constexpr Color orange{253, 141, 60};
+constexpr Color cyan{65, 182, 196};
+constexpr Color pink{231, 41, 138};
 /// @}
 
+/// The colors of the views, in order. The first four are for the usual 4-color maps.
+constexpr std::array<Color, 8> view_colors{red, yellow, green, blue,
+                                           purple, orange, cyan, pink};
+
 /// An integer transformation matrix for reflections and 90-degree rotations.
 struct Matrix
 {
     int xx{1}, xy{0};
     int yx{0}, yy{1};
+    bool operator==(Matrix const&) const = default;
 };
 
+/// The rotations of the square followed by the rotations of its reflection.
+constexpr std::array<Matrix, 8> orientations{{{1, 0, 0, 1}, {0, -1, 1, 0},
+                                              {-1, 0, 0, -1}, {0, 1, -1, 0},
+                                              {-1, 0, 0, 1}, {0, 1, 1, 0},
+                                              {1, 0, 0, -1}, {0, -1, -1, 0}}};
+
+/// An integer map from figure tiles to grid tiles.
+struct Placement
+{
+    Matrix transform;
+    Point<int> offset;
+    bool operator==(Placement const&) const = default;
+
+    /// @return The grid position of the figure tile @p p.
+    Point<int> operator()(Point<int> const& p) const
+    {
+        return {transform.xx*p.x + transform.xy*p.y + offset.x,
+                transform.yx*p.x + transform.yy*p.y + offset.y};
+    }
+};
+
+/// Placement arithmetic
+/// @{
+/// Multiply transformation matrices.
+Matrix operator*(Matrix const& m1, Matrix const& m2);
+/// @return The transpose of a matrix - the inverse of a transformation matrix.
+Matrix transpose(Matrix const& m);
+/// @return The position of the matrix in orientations.
+std::size_t orientation_index(Matrix const& m);
+/// @return The placement that applies @p p2 and then @p p1.
+Placement operator*(Placement const& p1, Placement const& p2);
+/// @return The placement that undoes @p p.
+Placement inverse(Placement const& p);
+/// @}
+
 /// A transformed polyomino figure
 class Figure_View
 {
@@ -51,9 +96,15 @@ public:
 
     /// @return A vector of transformed tiles.
     Tile_List tiles() const;
+    /// @return The transformation from figure tiles to grid tiles. Cheaper than tiles()
+    /// when the caller just needs to visit each tile.
+    Placement placement() const;
     /// @return The view's color.
     Color color() const;
 
+    /// Move and orient the view so that its tiles are those given by @p place applied to
+    /// the current figure.
+    Figure_View& place(Placement const& place);
     /// Add or remove a tile from source figure.
     Figure_View& toggle(Point<int> p);
 
@@ -14,63 +14,80 @@
 // If not, see <http://www.gnu.org/licenses/>.
 
 #include <grid_map.hh>
+#include <bitboard.hh>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 #include <list>
 #include <numbers>
-#include <numeric>
 
 /// The Cairo drawing context.
 using Context = Cairo::RefPtr<Cairo::Context>;
-/// A map of colors to tiles.
-using Figure_Map = std::map<Color, std::set<Point<int>>>;
 
 constexpr Point<int> left{-1, 0};
 constexpr Point<int> right{1, 0};
 constexpr Point<int> up{0, 1};
 constexpr Point<int> down{0, -1};
 
-/// Set the color in the drawing context.
-void set_color(Context const& cr, Color const& color,
-               double factor = 1.0, double alpha = 1.0)
-{
-    auto [r, g, b] = color;
-    cr->set_source_rgba(factor*r/255.0, factor*g/255.0, factor*b/255.0, alpha);
-}
+/// The smallest grid spacing in pixels. Grid lines are not drawn below this size.
+constexpr double min_grid_separation{4.0};
+/// The number of halvings of the tile size allowed by zooming out.
+constexpr int max_zoom_level{12};
+/// Limits on the search for the nearest map, which blocks the main loop.
+constexpr std::chrono::seconds snap_time{1};
+constexpr std::uint64_t snap_node_budget{50000};
 
 /// Draw the gridlines in a muted shade of the passed-in color.
-void draw_grid(Context const& cr, Color color, int divisions, int separation)
+/// @param separation The distance between lines in pixels.
+/// @param offset The position of the first line in pixels.
+void draw_grid(Context const& cr, Color color, int width, double separation, double offset)
 {
     // Use muted, semi-transparent lines for the grid.
     set_color(cr, color, 0.6, 0.4);
     cr->set_line_width(1);
-    auto width{separation*divisions};
-    for (auto i{0}; i < divisions; ++i)
+    // Don't bother with lines that would fill the field. Always draw the bottom edge.
+    if (separation >= min_grid_separation)
     {
-        cr->move_to(i*separation, 0);
-        cr->line_to(i*separation, width);
-        cr->move_to(0, i*separation);
-        cr->line_to(width, i*separation);
+        for (auto x{offset}; x < width; x += separation)
+        {
+            cr->move_to(x, 0);
+            cr->line_to(x, width);
+            cr->move_to(0, x);
+            cr->line_to(width, x);
+        }
     }
-    cr->move_to(0, divisions*separation);
-    cr->line_to(width, divisions*separation);
+    cr->move_to(0, width);
+    cr->line_to(width, width);
     cr->stroke();
 }
 
 /// Draw status info in the gap at the bottom.
 void draw_status(Context const& cr, int height, int tile_size,
                  bool is_contiguous, bool all_visible,
-                 bool four_color, int num_tiles,
-                 std::size_t undo_pos, std::size_t num_undos)
+                 std::size_t colors, std::size_t num_views, int num_tiles,
+                 std::size_t undo_pos, std::size_t num_undos,
+                 std::string const& exports, std::string const& maps,
+                 std::string const& contacts, std::string const& notice)
 {
     std::string undos{std::to_string(undo_pos) + "/" + std::to_string(num_undos)};
     std::vector<std::pair<std::string, bool>> states{{"C", is_contiguous},
                                                      {"V", all_visible},
-                                                     {"4", four_color},
+                                                     {std::to_string(colors),
+                                                      colors >= num_views},
                                                      {std::to_string(num_tiles), false},
                                                      {"", false},
-                                                     {undos, false}};
+                                                     {undos, false},
+                                                     {"", false},
+                                                     {exports, false},
+                                                     {"", false},
+                                                     {maps, false},
+                                                     {"", false},
+                                                     {"", false},
+                                                     {contacts, false}};
     Cairo::TextExtents te;
     auto y{height - 0.5*tile_size};
     for (auto i{0u}; auto const& state : states)
@@ -90,60 +107,66 @@ void draw_status(Context const& cr, int height, int tile_size,
         cr->move_to(x - te.x_bearing - 0.5*te.width, y - te.y_bearing - 0.5*te.height);
         cr->show_text(state.first);
     }
+    // Put the notice against the right edge.
+    if (!notice.empty())
+    {
+        set_color(cr, red);
+        cr->get_text_extents(notice, te);
+        cr->move_to(height - tile_size - te.x_advance - 0.5*tile_size,
+                    y - te.y_bearing - 0.5*te.height);
+        cr->show_text(notice);
+    }
 }
 
 /// @return The number of visible tiles. This is less than the total number of tiles if
 /// views overlap.
-std::size_t num_visible(Figure_Map const& fm)
-{
-    // Merge the set of the views. Duplicate tiles will be represented only once.
-    return std::accumulate(
-        fm.begin(), fm.end(), std::set<Point<int>>(),
-        [](auto const& ps, auto const& p){
-            auto p1{ps};
-            auto p2{p.second};
-            p1.merge(p2);
-            return p1;
-        }).size();
-}
-
-/// @return True if the tile at @p it shares an edge with at least one tile from the
-/// figures in the container up to @p end.
-bool touches_all(Figure_Map::const_iterator it, Figure_Map::const_iterator end)
-{
-    auto touches = [](Point<int> const& tile, std::set<Point<int>> const& others) {
-        for (auto other : others)
-            if ((std::abs(tile.x - other.x) == 1 && tile.y == other.y)
-                || (tile.x == other.x && std::abs(tile.y - other.y) == 1))
-                return true;
-        return false;
-    };
-
-    auto& tiles = it->second;
-    for (auto other = std::next(it); other != end; ++other)
-        if (std::all_of(tiles.begin(), tiles.end(),
-                        [touches, other](auto tile) { return !touches(tile, other->second); }))
-            return false;
-    return true;
+std::size_t num_visible(Figure const& figure, std::vector<Placement> const& placements)
+{
+    if (figure.tiles().empty() || placements.empty())
+        return 0;
+    auto box{bounds(figure, placements)};
+    Bitboard visible(box.width(), box.height());
+    for (auto const& place : placements)
+        for (auto const& tile : figure.tiles())
+            visible.set(place(tile) - box.low);
+    return visible.count();
 }
 
-/// @return True if the configuration represented by @p fn requires four colors.
-bool needs_four_colors(Figure_Map const& fm)
+/// @return The solution cache, or nullptr if it can't be opened.
+std::unique_ptr<Solution_Cache> make_cache(std::string const& file)
 {
-    for (auto itm = fm.begin(); itm != fm.end(); ++itm)
-        if (!touches_all(itm, fm.end()))
-            return false;
-    return !fm.empty();
+    try
+    {
+        return std::make_unique<Solution_Cache>(file);
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return nullptr;
+    }
 }
 
 // Grid_Map implementation
 
-Grid_Map::Grid_Map(int num_edge_tiles, int tile_size)
+Grid_Map::Grid_Map(int num_edge_tiles, int tile_size, std::size_t num_views,
+                   std::string const& journal_file, std::string const& cache_file)
     : m_num_edge_tiles(num_edge_tiles),
       m_tile_size(tile_size),
       m_image_export_chooser(
           std::make_unique<Gtk::FileChooserDialog>(
-              "Save figure image", Gtk::FILE_CHOOSER_ACTION_SAVE, Gtk::DIALOG_MODAL))
+              "Save figure image", Gtk::FILE_CHOOSER_ACTION_SAVE, Gtk::DIALOG_MODAL)),
+      m_session_save_chooser(
+          std::make_unique<Gtk::FileChooserDialog>(
+              "Save session", Gtk::FILE_CHOOSER_ACTION_SAVE, Gtk::DIALOG_MODAL)),
+      m_session_open_chooser(
+          std::make_unique<Gtk::FileChooserDialog>(
+              "Open session", Gtk::FILE_CHOOSER_ACTION_OPEN, Gtk::DIALOG_MODAL)),
+      m_journal_file(journal_file),
+      m_exports([this] { m_export_progress.emit(); }),
+      m_cache(cache_file.empty() ? nullptr : make_cache(cache_file)),
+      m_live_solver([this] { m_maps_found.emit(); }, m_cache.get(), num_views),
+      m_hinter([this] { m_hints_ready.emit(); }),
+      m_snapper([this] { m_snapped.emit(); })
 {
     set_can_focus(true);
     add_events(Gdk::KEY_PRESS_MASK | Gdk::BUTTON_PRESS_MASK);
@@ -158,13 +181,53 @@ Grid_Map::Grid_Map(int num_edge_tiles, int tile_size)
     PNG_Filter->add_mime_type("image/png");
     m_image_export_chooser->add_filter(PNG_Filter);
 
+    auto session_filter{Gtk::FileFilter::create()};
+    session_filter->set_name("4color sessions");
+    session_filter->add_pattern("*.4color");
+    m_session_save_chooser->set_modal(true);
+    m_session_save_chooser->signal_response().connect(
+        sigc::mem_fun(*this, &Grid_Map::save_session));
+    m_session_save_chooser->add_button("Save", Gtk::RESPONSE_OK);
+    m_session_save_chooser->add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+    m_session_save_chooser->add_filter(session_filter);
+    m_session_open_chooser->set_modal(true);
+    m_session_open_chooser->signal_response().connect(
+        sigc::mem_fun(*this, &Grid_Map::open_session));
+    m_session_open_chooser->add_button("Open", Gtk::RESPONSE_OK);
+    m_session_open_chooser->add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+    m_session_open_chooser->add_filter(session_filter);
+    m_session_open_chooser->add_filter(PNG_Filter);
+    m_export_progress.connect(sigc::mem_fun(*this, &Grid_Map::queue_draw));
+    m_maps_found.connect(sigc::mem_fun(*this, &Grid_Map::take_maps));
+    m_hints_ready.connect(sigc::mem_fun(*this, &Grid_Map::queue_draw));
+    m_snapped.connect(sigc::mem_fun(*this, &Grid_Map::apply_snap));
+
     // Add the views.
-    for (auto i{0}; const auto& color : {red, yellow, green, blue})
-        m_views.emplace_back(m_figure, Point{3*i++, 0}, color);
+    if (num_views == 0 || num_views > view_colors.size())
+        throw std::runtime_error("The number of views must be from 1 to "
+                                 + std::to_string(view_colors.size()));
+    for (std::size_t i{0}; i < num_views; ++i)
+        m_views.emplace_back(m_figure, Point{3*static_cast<int>(i), 0}, view_colors[i]);
     m_focused_figure = m_views.begin();
 
     m_history.emplace_back(Figure(), m_views, m_focused_figure);
     m_now = m_history.begin();
+
+    if (!m_journal_file.empty())
+        recover();
+    request_maps();
+    layout_changed();
+}
+
+Grid_Map::~Grid_Map()
+{
+    // A normal exit doesn't need recovery.
+    if (m_journal)
+    {
+        m_journal.reset();
+        std::filesystem::remove(m_journal_file);
+        std::filesystem::remove(journal_base_file());
+    }
 }
 
 void Grid_Map::focus_next_figure()
@@ -207,6 +270,16 @@ void Grid_Map::reset()
 void Grid_Map::update(std::deque<State>::const_iterator it)
 {
     m_now = it;
+    if (m_now->saved)
+    {
+        auto const state{*m_now->saved};
+        auto tiles{m_session->tiles(state)};
+        m_figure = Figure{Tile_List{tiles.begin(), tiles.end()}};
+        for (auto v{0u}; v < m_views.size(); ++v)
+            m_views[v].place(m_session->placements(state)[v]);
+        m_focused_figure = std::next(m_views.begin(), m_session->focus(state));
+        return;
+    }
     m_figure = m_now->figure;
     m_views = m_now->views;
     m_focused_figure = m_now->focused_figure;
@@ -230,53 +303,275 @@ void Grid_Map::do_transform(Figure_View& (Figure_View::*fcn)(), bool all)
              std::bind(fcn, std::placeholders::_1));
 }
 
-bool Grid_Map::on_key_press_event(GdkEventKey* event)
+void Grid_Map::apply(Edit const& edit)
 {
-    if (event->keyval == GDK_KEY_z)
+    switch (edit.type)
+    {
+    case Edit_Type::undo:
         undo();
-    else if (event->keyval == GDK_KEY_y)
+        return;
+    case Edit_Type::redo:
         redo();
-    else if (event->keyval == GDK_KEY_c)
+        return;
+    case Edit_Type::reset:
         reset();
+        return;
+    case Edit_Type::toggle:
+        m_focused_figure->toggle(edit.arg);
+        break;
+    case Edit_Type::translate:
+        do_transform(&Figure_View::translate, edit.all, edit.arg);
+        break;
+    case Edit_Type::rotate_ccw:
+        do_transform(&Figure_View::rotate_ccw, edit.all);
+        break;
+    case Edit_Type::rotate_cw:
+        do_transform(&Figure_View::rotate_cw, edit.all);
+        break;
+    case Edit_Type::flip:
+        do_transform(&Figure_View::flip_y, edit.all);
+        break;
+    case Edit_Type::focus:
+        focus_next_figure();
+        break;
+    }
+    record();
+}
+
+void Grid_Map::edit(Edit const& change)
+{
+    apply(change);
+    m_notice.clear();
+    if (m_journal)
+        m_journal->append(change);
+    request_maps();
+    layout_changed();
+}
+
+void Grid_Map::layout_changed()
+{
+    auto const places{placements()};
+    auto const matrix{contact_matrix(m_figure, places)};
+    auto regions{empty_regions(m_figure, places)};
+    auto const num_tiles{m_figure.tiles().size()};
+
+    m_analysis.contiguous = m_figure.is_contiguous();
+    m_analysis.all_visible = num_visible(m_figure, places) == m_views.size()*num_tiles;
+    m_analysis.colors = num_tiles == 0 ? 0 : chromatic_number(region_graph(matrix, regions));
+    // The number of edges shared by each pair of views.
+    m_analysis.contacts = "E";
+    for (std::size_t i{0}; i < matrix.size(); ++i)
+        for (auto j{i + 1}; j < matrix.size(); ++j)
+            m_analysis.contacts += (m_analysis.contacts.size() > 1 ? " " : "")
+                + std::to_string(matrix[i][j]);
+    // The first region is the outside.
+    if (!regions.empty())
+        regions.erase(regions.begin());
+    m_analysis.holes = std::move(regions);
+    request_hints();
+}
+
+void Grid_Map::request_hints()
+{
+    m_hint_generation = m_hinter.request(
+        {m_figure, placements()},
+        static_cast<std::size_t>(std::distance(m_views.begin(), m_focused_figure)));
+}
+
+void Grid_Map::request_maps()
+{
+    if (m_figure.tiles() == m_searched_figure.tiles())
+        return;
+    m_searched_figure = m_figure;
+    m_best_map.reset();
+    m_cached_count.reset();
+    if (m_figure.tiles().empty())
+    {
+        m_live_solver.cancel();
+        return;
+    }
+    if (auto cached{m_cache ? m_cache->find(m_figure) : std::nullopt})
+    {
+        m_live_solver.cancel();
+        m_cached_count = cached->count;
+        for (auto const& map : cached->solutions)
+            offer_map(map);
+    }
     else
+        m_search_generation = m_live_solver.solve(m_figure);
+}
+
+void Grid_Map::take_maps()
+{
+    for (auto const& map : m_live_solver.take())
+        offer_map(map);
+    queue_draw();
+}
+
+void Grid_Map::offer_map(Solution const& map)
+{
+    auto area{map_area(m_searched_figure, map)};
+    if (!m_best_map || area < m_best_area)
     {
-        auto shift{event->state & Gdk::ModifierType::SHIFT_MASK};
-        switch (event->keyval)
-        {
-        case GDK_KEY_Left:
-            do_transform(&Figure_View::translate, shift, left);
-            break;
-        case GDK_KEY_Right:
-            do_transform(&Figure_View::translate, shift, right);
-            break;
-        case GDK_KEY_Up:
-            do_transform(&Figure_View::translate, shift, up);
-            break;
-        case GDK_KEY_Down:
-            do_transform(&Figure_View::translate, shift, down);
-            break;
-        case GDK_KEY_Page_Up:
-            do_transform(&Figure_View::rotate_ccw, shift);
-            break;
-        case GDK_KEY_Page_Down:
-            do_transform(&Figure_View::rotate_cw, shift);
-            break;
-        case GDK_KEY_space: // Flip
-            do_transform(&Figure_View::flip_y, shift);
-            break;
-        case GDK_KEY_Tab: // Focus
-            focus_next_figure();
-            break;
-        case GDK_KEY_w: // Write
-            m_image_export_chooser->show();
-            break;
-        case GDK_KEY_q: // Quit
-            Gtk::Main::quit();
-            break;
-        default:
-            return true;
-        }
-        record();
+        m_best_map = map;
+        m_best_area = area;
+    }
+}
+
+void Grid_Map::load_best_map()
+{
+    if (!m_best_map || m_best_map->size() != m_views.size()
+        || m_figure.tiles() != m_searched_figure.tiles())
+        return;
+    // Put the unmoved copy on the focused view and the others on the following views.
+    auto anchor{m_focused_figure->placement()};
+    auto focus{std::distance(m_views.begin(), m_focused_figure)};
+    for (std::size_t k{0}; k < m_views.size(); ++k)
+        m_views[(focus + k) % m_views.size()].place(anchor*(*m_best_map)[k]);
+    record();
+    rebase_journal();
+    layout_changed();
+}
+
+void Grid_Map::snap_views()
+{
+    auto limits{Search_Limits::within(snap_time)};
+    limits.node_budget = snap_node_budget;
+    m_snap_start = {m_figure, placements()};
+    m_snap_generation = m_snapper.request(m_snap_start, limits);
+}
+
+void Grid_Map::apply_snap()
+{
+    if (!m_snap_generation)
+        return;
+    auto snapped{m_snapper.result(*m_snap_generation)};
+    if (!snapped)
+        return;
+    m_snap_generation.reset();
+    // Drop the snap if the layout changed while it ran.
+    if (m_figure.tiles() != m_snap_start.figure.tiles()
+        || placements() != m_snap_start.placements)
+        return;
+    if (!snapped->found)
+    {
+        m_notice = "No map within " + std::to_string(snapped->stats.nodes) + " layouts";
+        queue_draw();
+        return;
+    }
+    if (snapped->moves.empty())
+        return;
+    for (std::size_t v{0}; v < m_views.size(); ++v)
+        m_views[v].place(snapped->placements[v]);
+    record();
+    rebase_journal();
+    layout_changed();
+    queue_draw();
+}
+
+std::string Grid_Map::journal_base_file() const
+{
+    return m_journal_file + ".base";
+}
+
+void Grid_Map::recover()
+{
+    // A journal is left behind only if the program didn't exit normally. Its edits are
+    // applied to the last session opened, if any.
+    try
+    {
+        if (std::filesystem::exists(journal_base_file()))
+            load_session(journal_base_file());
+        for (auto const& edit : Journal::read(m_journal_file))
+            apply(edit);
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << "Can't recover from journal: " << error.what() << std::endl;
+        std::filesystem::remove(m_journal_file);
+        std::filesystem::remove(journal_base_file());
+    }
+
+    try
+    {
+        m_journal = std::make_unique<Journal>(m_journal_file);
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << error.what() << std::endl;
+    }
+}
+
+bool Grid_Map::on_key_press_event(GdkEventKey* event)
+{
+    auto shift{(event->state & Gdk::ModifierType::SHIFT_MASK) != 0};
+    switch (event->keyval)
+    {
+    case GDK_KEY_z:
+        edit({Edit_Type::undo});
+        break;
+    case GDK_KEY_y:
+        edit({Edit_Type::redo});
+        break;
+    case GDK_KEY_c:
+        edit({Edit_Type::reset});
+        break;
+    case GDK_KEY_minus:
+        zoom(1);
+        break;
+    case GDK_KEY_equal:
+    case GDK_KEY_plus:
+        zoom(-1);
+        break;
+    case GDK_KEY_Left:
+        edit({Edit_Type::translate, shift, left});
+        break;
+    case GDK_KEY_Right:
+        edit({Edit_Type::translate, shift, right});
+        break;
+    case GDK_KEY_Up:
+        edit({Edit_Type::translate, shift, up});
+        break;
+    case GDK_KEY_Down:
+        edit({Edit_Type::translate, shift, down});
+        break;
+    case GDK_KEY_Page_Up:
+        edit({Edit_Type::rotate_ccw, shift});
+        break;
+    case GDK_KEY_Page_Down:
+        edit({Edit_Type::rotate_cw, shift});
+        break;
+    case GDK_KEY_space: // Flip
+        edit({Edit_Type::flip, shift});
+        break;
+    case GDK_KEY_Tab: // Focus
+        edit({Edit_Type::focus});
+        break;
+    case GDK_KEY_w: // Write
+        m_image_export_chooser->show();
+        break;
+    case GDK_KEY_s: // Save session. Hold shift to leave out the history.
+    case GDK_KEY_S:
+        m_save_history = !shift;
+        m_session_save_chooser->show();
+        break;
+    case GDK_KEY_o: // Open session
+        m_session_open_chooser->show();
+        break;
+    case GDK_KEY_m: // Load the best map found for the figure
+        load_best_map();
+        break;
+    case GDK_KEY_n: // Move the views to the nearest map
+        snap_views();
+        break;
+    case GDK_KEY_h: // Show or hide move hints
+        m_show_hints = !m_show_hints;
+        break;
+    case GDK_KEY_q: // Quit
+        Gtk::Main::quit();
+        break;
+    default:
+        return true;
     }
     queue_draw();
     return true;
@@ -284,9 +579,12 @@ bool Grid_Map::on_key_press_event(GdkEventKey* event)
 
 bool Grid_Map::on_button_press_event(GdkEventButton* event)
 {
-    m_focused_figure->toggle(Point{static_cast<int>(event->x)/m_tile_size,
-                                   static_cast<int>(height() - event->y)/m_tile_size - 1});
-    record();
+    // Invert the field transformation given by frame().
+    auto s{scale()};
+    auto c{0.5*m_num_edge_tiles};
+    edit({Edit_Type::toggle, false,
+          flooround(Point{(event->x - 0.5*width())/s + c - 0.5,
+                          (0.5*width() - event->y)/s + c - 0.5})});
     queue_draw();
     return true;
 }
@@ -301,38 +599,154 @@ int Grid_Map::height() const
     return width() + m_tile_size;
 }
 
+void Grid_Map::zoom(int steps)
+{
+    m_zoom_level = std::clamp(m_zoom_level + steps, 0, max_zoom_level);
+}
+
+double Grid_Map::scale() const
+{
+    return std::ldexp(m_tile_size, -m_zoom_level);
+}
+
+Frame Grid_Map::frame() const
+{
+    // Zoom about the center of the field.
+    auto size{width()/scale()};
+    auto corner{0.5*(m_num_edge_tiles - size)};
+    return {{corner, corner}, size, size};
+}
+
+std::vector<Placement> Grid_Map::placements() const
+{
+    std::vector<Placement> places;
+    for (auto const& view : m_views)
+        places.push_back(view.placement());
+    return places;
+}
+
 bool Grid_Map::on_draw(Context const& cr)
 {
-    if (!m_write_to_file)
-        draw_grid(cr, m_focused_figure->color(), m_num_edge_tiles, m_tile_size);
+    auto s{scale()};
+    auto offset{std::fmod(0.5*width() - 0.5*m_num_edge_tiles*s, s)};
+    draw_grid(cr, m_focused_figure->color(), width(), s, offset);
 
-    std::map<Color, std::set<Point<int>>> plotted;
-    auto m1{cr->get_matrix()};
+    // Draw the other figures before the focused figure.
+    auto const places{placements()};
     auto focus_index{std::distance(m_views.begin(), m_focused_figure)};
-    cr->scale(m_tile_size, m_tile_size);
-    for (auto i{0u}; i < m_views.size(); ++i)
-    {
-        // Draw the other figures before the focused figure.
-        const auto& fig{m_views[(i + focus_index + 1) % m_views.size()]};
-        set_color(cr, fig.color());
-        for (auto const& tile : fig.tiles())
+    draw_views(cr, m_figure, places, frame(), s, m_pixels, focus_index);
+    draw_holes(cr);
+
+    if (m_show_hints)
+        if (auto hints{m_hinter.hints(m_hint_generation)})
+            draw_hints(cr, *hints);
+
+    // Show the progress of the current export and the number waiting.
+    std::string exports;
+    if (auto pending{m_exports.pending()}; pending > 0)
+        exports = "W" + std::to_string(m_exports.percent_done()) + "%"
+            + (pending > 1 ? " +" + std::to_string(pending - 1) : "");
+
+    // Show the number of maps for the figure, and the progress if it's being searched.
+    std::string maps;
+    if (m_cached_count)
+        maps = "M" + std::to_string(*m_cached_count);
+    else if (auto status{m_live_solver.status()};
+             !m_figure.tiles().empty() && status.generation == m_search_generation)
+        maps = "M" + std::to_string(status.found)
+            + (status.done ? "" : " " + std::to_string(status.percent) + "%");
+
+    draw_status(cr, height(), m_tile_size,
+                m_analysis.contiguous, m_analysis.all_visible,
+                m_analysis.colors, m_views.size(), m_figure.tiles().size(),
+                std::distance(m_history.cbegin(), m_now) + 1, m_history.size(),
+                exports, maps, m_analysis.contacts, m_notice);
+    return true;
+}
+
+Point<double> Grid_Map::to_screen(Point<int> tile) const
+{
+    // The inverse of the transformation in on_button_press_event().
+    auto s{scale()};
+    auto c{0.5*m_num_edge_tiles};
+    return {(tile.x + 0.5 - c)*s + 0.5*width(), 0.5*width() - (tile.y + 0.5 - c)*s};
+}
+
+void Grid_Map::draw_holes(Context const& cr) const
+{
+    // Shade the empty regions that the views enclose. They're regions of the map too.
+    auto s{scale()};
+    set_color(cr, black, 1.0, 0.25);
+    for (auto const& hole : m_analysis.holes)
+        for (auto const& t : hole.tiles)
         {
-            plotted[fig.color()].insert(tile);
-            cr->rectangle(tile.x, m_num_edge_tiles - tile.y - 1, 1, 1);
+            auto p{to_screen(t)};
+            cr->rectangle(p.x - 0.5*s, p.y - 0.5*s, s, s);
         }
-        cr->fill();
-    }
-    cr->set_matrix(m1);
+    cr->fill();
+}
 
-    auto num_tiles{m_figure.tiles().size()};
-    auto all_visible{num_visible(plotted) == m_views.size()*num_tiles};
-    if (!m_write_to_file)
-        draw_status(cr, height(), m_tile_size,
-                    m_figure.is_contiguous(), all_visible,
-                    needs_four_colors(plotted), num_tiles,
-                    std::distance(m_history.cbegin(), m_now) + 1, m_history.size());
+void Grid_Map::draw_hints(Context const& cr, std::vector<Move_Hint> const& hints) const
+{
+    auto s{scale()};
+    if (s < min_grid_separation || m_figure.tiles().empty())
+        return;
 
-    return true;
+    // Put the translation hints beside the view's edges and the others at its corners.
+    auto [low, high]{bounds(m_focused_figure->tiles())};
+    Point<int> mid{(low.x + high.x)/2, (low.y + high.y)/2};
+    auto position{[&](Edit const& move) -> Point<int> {
+        switch (move.type)
+        {
+        case Edit_Type::translate:
+            if (move.arg.x < 0)
+                return {low.x - 1, mid.y};
+            if (move.arg.x > 0)
+                return {high.x + 1, mid.y};
+            if (move.arg.y > 0)
+                return {mid.x, high.y + 1};
+            return {mid.x, low.y - 1};
+        case Edit_Type::rotate_ccw:
+            return {low.x - 1, high.y + 1};
+        case Edit_Type::rotate_cw:
+            return {high.x + 1, high.y + 1};
+        default:
+            return {high.x + 1, low.y - 1};
+        }
+    }};
+    auto label{[](Move_Hint const& hint) {
+        auto n{std::to_string(hint.touches)};
+        switch (hint.move.type)
+        {
+        case Edit_Type::rotate_ccw:
+            return "\u21ba" + n;
+        case Edit_Type::rotate_cw:
+            return "\u21bb" + n;
+        case Edit_Type::flip:
+            return "\u21c4" + n;
+        default:
+            return n;
+        }
+    }};
+
+    Cairo::TextExtents te;
+    cr->set_font_size(0.5*s);
+    for (auto const& hint : hints)
+    {
+        // Red for overlap, green for touching all of the other views.
+        auto color{hint.overlaps ? red
+                   : hint.touches + 1 == m_views.size() ? green
+                   : Color{200, 200, 200}};
+        auto p{to_screen(position(hint.move))};
+        set_color(cr, color, 1.0, 0.7);
+        cr->arc(p.x, p.y, 0.45*s, 0, 2.0*std::numbers::pi);
+        cr->fill();
+        set_color(cr, black);
+        auto text{label(hint)};
+        cr->get_text_extents(text, te);
+        cr->move_to(p.x - te.x_bearing - 0.5*te.width, p.y - te.y_bearing - 0.5*te.height);
+        cr->show_text(text);
+    }
 }
 
 void Grid_Map::export_png(int response)
@@ -341,10 +755,146 @@ void Grid_Map::export_png(int response)
     if (response != Gtk::RESPONSE_OK)
         return;
 
-    m_write_to_file = true;
-    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width(), width());
-    auto cr = Cairo::Context::create(surface);
-    on_draw(cr);
-    surface->write_to_png(m_image_export_chooser->get_file()->get_path());
-    m_write_to_file = false;
+    // Take a copy of the figure and views now. The image is drawn and encoded on the
+    // export queue's thread while editing continues.
+    m_exports.push({m_image_export_chooser->get_file()->get_path(),
+                    {m_figure, placements()}, frame(), scale()});
+    queue_draw();
+}
+
+void Grid_Map::save_session(int response)
+{
+    m_session_save_chooser->hide();
+    if (response != Gtk::RESPONSE_OK)
+        return;
+
+    try
+    {
+        write_session(m_session_save_chooser->get_file()->get_path(),
+                      session_states(m_save_history),
+                      m_save_history ? std::distance(m_history.cbegin(), m_now) : 0);
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << error.what() << std::endl;
+    }
+}
+
+std::vector<Session_State> Grid_Map::session_states(bool history)
+{
+    // The views in the history refer to m_figure, so each state must be made current to
+    // get its placements.
+    auto now{m_now};
+    std::vector<Session_State> states;
+    auto add_state = [this, &states]() {
+        states.push_back({{m_figure, placements()},
+                          static_cast<std::size_t>(
+                              std::distance(m_views.begin(), m_focused_figure))});
+    };
+    if (history)
+        for (auto it{m_history.cbegin()}; it != m_history.cend(); ++it)
+        {
+            update(it);
+            add_state();
+        }
+    else
+        add_state();
+    update(now);
+    return states;
+}
+
+void Grid_Map::rebase_journal()
+{
+    if (!m_journal)
+        return;
+    try
+    {
+        write_session(journal_base_file(), session_states(true),
+                      std::distance(m_history.cbegin(), m_now));
+        m_journal->clear();
+    }
+    catch (std::runtime_error const& error)
+    {
+        std::cerr << error.what() << std::endl;
+    }
+}
+
+void Grid_Map::open_session(int response)
+{
+    m_session_open_chooser->hide();
+    if (response != Gtk::RESPONSE_OK)
+        return;
+
+    auto file{m_session_open_chooser->get_file()->get_path()};
+    try
+    {
+        // Start a new journal based on the opened session.
+        if (std::filesystem::path{file}.extension() == ".png")
+        {
+            load_png(file);
+            if (m_journal)
+                write_session(journal_base_file(),
+                              {{{m_figure, placements()},
+                                static_cast<std::size_t>(
+                                    std::distance(m_views.begin(), m_focused_figure))}},
+                              0);
+        }
+        else
+        {
+            load_session(file);
+            if (m_journal)
+                std::filesystem::copy_file(file, journal_base_file(),
+                                           std::filesystem::copy_options::overwrite_existing);
+        }
+        if (m_journal)
+            m_journal->clear();
+        request_maps();
+        layout_changed();
+    }
+    catch (std::exception const& error)
+    {
+        std::cerr << error.what() << std::endl;
+    }
+    queue_draw();
+}
+
+void Grid_Map::load_session(std::string const& file)
+{
+    try
+    {
+        auto session{std::make_unique<Session_File>(file)};
+        if (session->num_views() != m_views.size())
+            throw std::runtime_error("Session has "
+                                     + std::to_string(session->num_views()) + " views");
+        // The states stay in the mapped file until they're visited.
+        std::deque<State> history;
+        for (std::size_t i{0}; i < session->num_states(); ++i)
+            history.push_back({Figure{}, {}, {}, i});
+        auto now{session->now()};
+        m_session = std::move(session);
+        m_history = std::move(history);
+        update(std::next(m_history.cbegin(), now));
+    }
+    catch (std::runtime_error const&)
+    {
+        // Put back the current state.
+        update(m_now);
+        throw;
+    }
+}
+
+void Grid_Map::load_png(std::string const& file)
+{
+    auto layout{read_png(file)};
+    if (layout.placements.size() != m_views.size())
+        throw std::runtime_error(file + " has " + std::to_string(layout.placements.size())
+                                 + " figures");
+    m_figure = layout.figure;
+    for (auto v{0u}; v < m_views.size(); ++v)
+        m_views[v].place(layout.placements[v]);
+    m_focused_figure = m_views.begin();
+    m_history.clear();
+    m_history.emplace_back(m_figure, m_views, m_focused_figure);
+    m_now = m_history.begin();
+    m_session.reset();
 }
@@ -16,12 +16,27 @@
 #ifndef FOUR_COLOR_LIB4COLOR_GRID_MAP_HH_INCLUDED
 #define FOUR_COLOR_LIB4COLOR_GRID_MAP_HH_INCLUDED
 
+#include <contact.hh>
+#include <export_queue.hh>
 #include <figure.hh>
 #include <figure_view.hh>
+#include <holes.hh>
+#include <journal.hh>
+#include <live_solver.hh>
+#include <move_hints.hh>
+#include <png_reader.hh>
+#include <region_graph.hh>
+#include <render.hh>
+#include <session.hh>
+#include <snap.hh>
+#include <solution_cache.hh>
 
 #include <gtkmm.h>
 
+#include <cstdint>
 #include <deque>
+#include <memory>
+#include <optional>
 #include <vector>
 
 /// A 2D field for displaying polyominos.
@@ -33,7 +48,17 @@ public:
     /// Create a grid
     /// @param num_edge_tiles The number of squares in each direction in pixels.
     /// @param tile_size The width and height of each square in pixels.
-    Grid_Map(int num_edge_tiles, int tile_size);
+    /// @param num_views The number of copies of the figure, each in its own color.
+    /// @param journal_file If not empty, edits are saved to this file as they're made. If
+    /// the file exists when the grid is created, its edits are replayed.
+    /// @param cache_file If not empty, the number of maps for the figure is looked up in
+    /// this solution cache, and the results of background searches are stored there.
+    /// The cache and the journal should be used only with this number of views.
+    /// @throw std::runtime_error if there are no views or more than there are colors.
+    Grid_Map(int num_edge_tiles, int tile_size, std::size_t num_views = 4,
+             std::string const& journal_file = {}, std::string const& cache_file = {});
+    /// Remove the journal file.
+    ~Grid_Map();
 
     /// @return The width of the field in pixels.
     int width() const;
@@ -50,12 +75,77 @@ private:
 
     /// Change the figure that events apply to.
     void focus_next_figure();
-    /// Render the configuration to the file "4color.png".
+    /// Zoom in or out by a factor of 2 about the center of the field.
+    void zoom(int steps);
+    /// @return The size of a tile in pixels at the current zoom level.
+    double scale() const;
+    /// @return The part of the grid that's visible at the current zoom level.
+    Frame frame() const;
+    /// @return The placements of the views.
+    std::vector<Placement> placements() const;
+    /// Queue a PNG image of the configuration to be written to the file chosen in the
+    /// file selector.
     void export_png(int response);
+    /// Save the state, and the history if m_save_history is set, to the file chosen in
+    /// the session file selector.
+    void save_session(int response);
+    /// Replace the state and history with those from the chosen session file or PNG
+    /// image.
+    void open_session(int response);
+    /// Replace the state and history with those from a session file. The file stays
+    /// mapped, and each state is read from it when it's visited.
+    /// @throw std::runtime_error if the file can't be loaded. The state is unchanged.
+    void load_session(std::string const& file);
+    /// Replace the state with the figures in a PNG image and clear the history.
+    /// @throw std::runtime_error if the image doesn't have a copy of the figure for each
+    /// view. The state is unchanged.
+    void load_png(std::string const& file);
+
+    /// Make a change without saving it in the journal.
+    void apply(Edit const& edit);
+    /// Make a change and add it to the journal.
+    void edit(Edit const& change);
+    /// Replay the journal left from a previous run and start appending to it.
+    void recover();
+    /// @return The name of the session file that the journal's edits apply to.
+    std::string journal_base_file() const;
+    /// If the figure has changed, look up its maps in the cache or start searching for
+    /// them in the background.
+    void request_maps();
+    /// Work out what the status area and the hole shading show for a new layout, and
+    /// start evaluating the focused view's moves.
+    void layout_changed();
+    /// Start evaluating the focused view's moves in the background.
+    void request_hints();
+    /// Shade the empty regions enclosed by the views.
+    void draw_holes(Context const& cr) const;
+    /// Draw the scores of the focused view's moves around it.
+    void draw_hints(Context const& cr, std::vector<Move_Hint> const& hints) const;
+    /// @return The position in pixels of the center of a tile.
+    Point<double> to_screen(Point<int> tile) const;
+    /// Collect the maps found by the background search.
+    void take_maps();
+    /// Consider a map for m_best_map.
+    void offer_map(Solution const& map);
+    /// Move the views to the best map found, keeping the focused view in place.
+    void load_best_map();
+    /// Start looking for the map that takes the fewest moves to reach.
+    void snap_views();
+    /// Move the views to the map found by snap_views(), if one was found quickly and the
+    /// layout hasn't changed since.
+    void apply_snap();
+    /// @return The states to save in a session file. Just the current one unless
+    /// @p history is set.
+    std::vector<Session_State> session_states(bool history);
+    /// Start a new journal based on the current state and history.
+    void rebase_journal();
 
     int m_num_edge_tiles;
     int m_tile_size;
-    bool m_write_to_file{false};
+    /// The number of times the field has been zoomed out by a factor of 2.
+    int m_zoom_level{0};
+    /// The image the views are drawn on when zoomed out to a pixel per tile or less.
+    Cairo::RefPtr<Cairo::ImageSurface> m_pixels;
 
     Figure m_figure;
     std::vector<Figure_View> m_views;
@@ -75,6 +165,9 @@ private:
         Figure figure;
         std::vector<Figure_View> views;
         std::vector<Figure_View>::iterator focused_figure;
+        /// If set, the state is read from m_session when it's visited, and the members
+        /// above are unused.
+        std::optional<std::size_t> saved{};
     };
     /// Erase states after m_now and add the current state.
     void record();
@@ -90,8 +183,71 @@ private:
     std::deque<State> m_history;
     /// An iterator to the current state.
     std::deque<State>::const_iterator m_now;
+    /// The mapped session file that the saved states in the history are read from.
+    std::unique_ptr<Session_File> m_session;
     /// The file selector for saving an image of the figures.
     std::unique_ptr<Gtk::FileChooserDialog> m_image_export_chooser;
+    /// The file selectors for saving and opening sessions.
+    std::unique_ptr<Gtk::FileChooserDialog> m_session_save_chooser;
+    std::unique_ptr<Gtk::FileChooserDialog> m_session_open_chooser;
+    /// True if the undo history is to be saved along with the current state.
+    bool m_save_history{true};
+    std::string m_journal_file;
+    /// Saves edits in the background.
+    std::unique_ptr<Journal> m_journal;
+    /// Passes export progress from the export queue's thread to the main loop.
+    Glib::Dispatcher m_export_progress;
+    /// Writes images in the background. Declared after the dispatcher it notifies so
+    /// that it's stopped first.
+    Export_Queue m_exports;
+    /// The figure whose maps are being looked for.
+    Figure m_searched_figure;
+    /// The number of maps in the cache for m_searched_figure, if it was there.
+    std::optional<std::size_t> m_cached_count;
+    /// The generation of the background search for m_searched_figure.
+    std::uint64_t m_search_generation{0};
+    /// The map of m_searched_figure with the smallest area found so far.
+    std::optional<Solution> m_best_map;
+    std::size_t m_best_area{0};
+    /// Search results for figures drawn before.
+    std::unique_ptr<Solution_Cache> m_cache;
+    /// Passes news of the background search to the main loop.
+    Glib::Dispatcher m_maps_found;
+    /// Searches for maps of the figure as it's edited. Stopped before the dispatcher and
+    /// the cache.
+    Live_Solver m_live_solver;
+    /// The analysis of the current layout, worked out by layout_changed() so that drawing
+    /// only paints it.
+    struct Analysis
+    {
+        bool contiguous{true};
+        bool all_visible{true};
+        /// The number of colors the map needs.
+        std::size_t colors{0};
+        /// The edges shared by each pair of views, as shown in the status area.
+        std::string contacts;
+        /// The empty regions enclosed by the views.
+        std::vector<Hole> holes;
+    };
+    Analysis m_analysis;
+    /// The outcome of a command that had no effect, shown in the status area until the
+    /// next edit.
+    std::string m_notice;
+    /// True if the move hints are drawn.
+    bool m_show_hints{true};
+    /// The generation of the hint request for the current state.
+    std::uint64_t m_hint_generation{0};
+    /// Passes news of finished hints to the main loop.
+    Glib::Dispatcher m_hints_ready;
+    /// Evaluates the focused view's moves. Stopped before the dispatcher.
+    Move_Hinter m_hinter;
+    /// The layout being snapped and the generation of its request, if it's not done.
+    Layout m_snap_start;
+    std::optional<std::uint64_t> m_snap_generation;
+    /// Passes news of a finished snap to the main loop.
+    Glib::Dispatcher m_snapped;
+    /// Looks for the nearest map. Stopped before the dispatcher.
+    Snapper m_snapper;
 };
 
 #endif // FOUR_COLOR_LIB4COLOR_GRID_MAP_HH_INCLUDED
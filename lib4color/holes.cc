@@ -0,0 +1,80 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "holes.hh"
+#include "bitboard.hh"
+#include "layout.hh"
+
+#include <algorithm>
+
+std::vector<Hole> empty_regions(Figure const& figure,
+                                std::vector<Placement> const& placements)
+{
+    if (figure.tiles().empty() || placements.empty())
+        return {};
+
+    // A grid around the map with a ring of empty tiles, which are all outside.
+    auto box{bounds(figure, placements)};
+    auto const low{box.low - Point<int>{1, 1}};
+    auto const width{box.width() + 2};
+    auto const height{box.height() + 2};
+    Bitboard empty(width, height);
+    // The copy on each tile, or -1 if it's empty.
+    std::vector<int> owner(width*height, -1);
+    for (std::size_t c{0}; c < placements.size(); ++c)
+        for (auto const& tile : figure.tiles())
+        {
+            auto p{placements[c](tile) - low};
+            empty.set(p);
+            owner[p.y*width + p.x] = c;
+        }
+    empty.invert();
+
+    // The first tile is on the ring, so the first region is the outside. Tiles on the
+    // ring have neighbors off the grid, but they're all empty.
+    auto const labeled{label_pieces(empty)};
+    std::vector<Hole> regions(labeled.sizes.size());
+    for (auto i{0}; i < width*height; ++i)
+    {
+        if (owner[i] >= 0)
+            continue;
+        auto& hole{regions[labeled.labels[i]]};
+        hole.tiles.push_back(low + Point<int>{i % width, i/width});
+        auto x{i % width};
+        if (x > 0 && owner[i - 1] >= 0)
+            hole.copies.push_back(owner[i - 1]);
+        if (x + 1 < width && owner[i + 1] >= 0)
+            hole.copies.push_back(owner[i + 1]);
+        if (i >= width && owner[i - width] >= 0)
+            hole.copies.push_back(owner[i - width]);
+        if (i + width < width*height && owner[i + width] >= 0)
+            hole.copies.push_back(owner[i + width]);
+    }
+    for (auto& hole : regions)
+    {
+        std::sort(hole.copies.begin(), hole.copies.end());
+        hole.copies.erase(std::unique(hole.copies.begin(), hole.copies.end()),
+                          hole.copies.end());
+    }
+    return regions;
+}
+
+std::vector<Hole> find_holes(Figure const& figure, std::vector<Placement> const& placements)
+{
+    auto regions{empty_regions(figure, placements)};
+    if (!regions.empty())
+        regions.erase(regions.begin());
+    return regions;
+}
@@ -0,0 +1,44 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_HOLES_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_HOLES_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+
+#include <vector>
+
+/// An edge-connected region of empty tiles around the copies of a figure. A hole is one
+/// that's cut off from the outside. It's an extra, uncolored region of the map.
+struct Hole
+{
+    std::vector<Point<int>> tiles;
+    /// The indices of the copies that share an edge with the hole, in order.
+    std::vector<std::size_t> copies;
+};
+
+/// @return The edge-connected regions of empty tiles around the copies of a figure. The
+/// first is the outside, which includes a ring of tiles around the map. The rest are the
+/// holes.
+std::vector<Hole> empty_regions(Figure const& figure,
+                                std::vector<Placement> const& placements);
+
+/// @return The holes left by the copies of a figure. The empty tiles around the copies
+/// are labeled with a two-pass scanline labeling, so the time is linear in the area of
+/// the map.
+std::vector<Hole> find_holes(Figure const& figure, std::vector<Placement> const& placements);
+
+#endif // FOUR_COLOR_LIB4COLOR_HOLES_HH_INCLUDED
@@ -0,0 +1,528 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "joint_search.hh"
+
+#include <algorithm>
+#include <array>
+#include <map>
+
+std::array<Point<int>, 4> const steps{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+/// The most figures that Joint_Search remembers the placements of.
+std::size_t const max_remembered{1 << 16};
+
+/// The state of a search for figures of a given size and their maps.
+class Joint_Search
+{
+public:
+    /// @param report Called for each map. Returns true to end the search.
+    Joint_Search(std::size_t tiles,
+                 std::size_t copies,
+                 Search_Control& control,
+                 std::function<bool(Layout const&)> report);
+    /// Grow figures from a tile at the origin.
+    void run();
+    /// @return The number of maps reported.
+    std::size_t found() const;
+
+private:
+    /// @return The index of a grid position, or -1 if it's out of range.
+    int index(Point<int> p) const;
+    /// Give a grid position to a copy and count the contacts it makes.
+    /// @return False if the position is taken or out of range.
+    bool claim(Point<int> p, std::size_t copy);
+    void release(Point<int> p, std::size_t copy);
+    /// Add a tile to the figure and the copies placed so far.
+    /// @return False if a copy's tile would be on another's.
+    bool add_tile(Point<int> tile);
+    void remove_tile(Point<int> tile);
+    /// Place a copy so that all its tiles are free.
+    /// @return False if one is taken.
+    bool place_copy(std::size_t copy, Placement const& place);
+    void remove_copy(std::size_t copy);
+    /// @return True if each placed copy's tile at @p p is free.
+    bool addable(Point<int> p) const;
+    /// @return A lower bound on the number of tiles to add from @p untried and beyond
+    /// before there's a map.
+    std::size_t tiles_needed(std::vector<Point<int>> const& untried);
+    /// @return The placements of a copy that touch the unmoved copy first at @p tile,
+    /// whatever the other copies are. These depend only on the figure, so they're
+    /// remembered.
+    std::vector<Placement> const& touching_unmoved(Point<int> tile);
+    /// @return The placements of the next copy that touch the unmoved copy first at
+    /// @p tile and fit among the copies placed so far.
+    std::vector<Placement> candidates(Point<int> tile);
+    /// @return True if a copy placed at @p place would share an edge with each placed
+    /// copy.
+    bool touches_placed(Placement const& place);
+    /// @return False if the search has ended or there can't be a map with the tiles
+    /// that are left.
+    bool promising(std::vector<Point<int>> const& untried);
+    /// Try placing the next copies, or not, now that @p tile has been added.
+    void place_next(Point<int> tile, std::vector<Point<int>> const& untried);
+    /// Place the next copy at each of @p candidates from @p first on, and go on from
+    /// there.
+    void place_copies(Point<int> tile, std::vector<Point<int>> const& untried,
+                      std::vector<Placement> const& candidates, std::size_t first);
+    /// Go on adding tiles from @p untried, or report the map if the figure is full.
+    void extend(std::vector<Point<int>> const& untried);
+    /// Add each tile in @p untried in turn, and the tiles after it in the list or next to
+    /// it, Redelmeier's way.
+    void grow(std::vector<Point<int>> untried);
+
+    std::size_t const m_tiles;
+    Search_Control& m_control;
+    Search_Control::Counter m_counter;
+    std::function<bool(Layout const&)> m_report;
+    bool m_done{false};
+    std::size_t m_found{0};
+
+    /// The grid is big enough for any copy that touches the unmoved one.
+    int const m_reach;
+    int const m_side;
+    /// The index of the seed. The copies are numbered so that the unmoved one holds the
+    /// map's first tile in row order, so no copy has a tile before it.
+    int const m_first;
+    /// The copy at each grid position, or -1.
+    std::vector<int> m_owner;
+    /// The number of the unmoved copy's tiles next to each grid position.
+    std::vector<int> m_near;
+    /// Marks the offsets that touching_unmoved() has tried for an orientation.
+    std::vector<unsigned> m_offset_stamps;
+    unsigned m_stamp{0};
+    /// The results of touching_unmoved() for each figure, up to max_remembered figures.
+    /// The same figure is grown again for each way of placing the copies before its last
+    /// tile was added.
+    std::map<std::vector<Point<int>>, std::vector<Placement>> m_remembered;
+    /// The result of touching_unmoved() when there's no room to remember it.
+    std::vector<Placement> m_forgotten;
+    /// The copies that a candidate touches. Used by touches_placed().
+    std::vector<bool> m_touched;
+    /// True for positions that are in the figure or have been offered for it.
+    std::vector<bool> m_seen;
+    /// The number of tiles it takes to add each position, or -1. Used by tiles_needed().
+    std::vector<int> m_depth;
+    std::vector<Point<int>> m_reached;
+    std::vector<Point<int>> m_figure;
+    std::vector<Placement> m_placements;
+    /// The placed copies' tiles.
+    std::vector<std::vector<Point<int>>> m_copy_tiles;
+    /// The number of edges shared by each pair of copies.
+    std::vector<std::vector<int>> m_contacts;
+};
+
+Joint_Search::Joint_Search(std::size_t tiles,
+                           std::size_t copies,
+                           Search_Control& control,
+                           std::function<bool(Layout const&)> report)
+    : m_tiles{tiles},
+      m_control{control},
+      m_report{std::move(report)},
+      m_reach{4*static_cast<int>(tiles) + 2},
+      m_side{2*m_reach + 1},
+      m_first{m_reach*m_side + m_reach},
+      m_owner(m_side*m_side, -1),
+      m_near(m_side*m_side, 0),
+      m_offset_stamps(m_side*m_side, 0),
+      m_seen(m_side*m_side, false),
+      m_depth(m_side*m_side, -1),
+      m_placements{Placement{}},
+      m_copy_tiles(copies),
+      m_contacts(copies, std::vector<int>(copies, 0))
+{
+    m_placements.reserve(copies);
+}
+
+void Joint_Search::run()
+{
+    if (m_tiles == 0 || m_copy_tiles.empty())
+        return;
+    // Each figure is grown once, from its first tile in row order, so the positions
+    // before the seed are never offered. The other copies are placed as the tiles that
+    // make them touch the unmoved copy are added.
+    Point<int> const seed{0, 0};
+    std::fill(m_seen.begin(), m_seen.begin() + index(seed) + 1, true);
+    add_tile(seed);
+    std::vector<Point<int>> untried;
+    for (auto const& d : steps)
+        if (!m_seen[index(seed + d)])
+        {
+            m_seen[index(seed + d)] = true;
+            untried.push_back(seed + d);
+        }
+    place_next(seed, untried);
+    m_control.flush(m_counter);
+}
+
+std::size_t Joint_Search::found() const
+{
+    return m_found;
+}
+
+int Joint_Search::index(Point<int> p) const
+{
+    return std::abs(p.x) <= m_reach && std::abs(p.y) <= m_reach
+        ? (p.y + m_reach)*m_side + p.x + m_reach : -1;
+}
+
+bool Joint_Search::claim(Point<int> p, std::size_t copy)
+{
+    auto i{index(p)};
+    if (i < m_first || m_owner[i] >= 0)
+        return false;
+    m_owner[i] = copy;
+    for (auto const& d : steps)
+        if (auto j{index(p + d)}; j >= 0)
+        {
+            m_near[j] += copy == 0;
+            if (m_owner[j] >= 0 && m_owner[j] != static_cast<int>(copy))
+            {
+                ++m_contacts[copy][m_owner[j]];
+                ++m_contacts[m_owner[j]][copy];
+            }
+        }
+    m_copy_tiles[copy].push_back(p);
+    return true;
+}
+
+void Joint_Search::release(Point<int> p, std::size_t copy)
+{
+    m_copy_tiles[copy].pop_back();
+    m_owner[index(p)] = -1;
+    for (auto const& d : steps)
+        if (auto j{index(p + d)}; j >= 0)
+        {
+            m_near[j] -= copy == 0;
+            if (m_owner[j] >= 0 && m_owner[j] != static_cast<int>(copy))
+            {
+                --m_contacts[copy][m_owner[j]];
+                --m_contacts[m_owner[j]][copy];
+            }
+        }
+}
+
+bool Joint_Search::add_tile(Point<int> tile)
+{
+    for (std::size_t c{0}; c < m_placements.size(); ++c)
+        if (!claim(m_placements[c](tile), c))
+        {
+            while (c-- > 0)
+                release(m_placements[c](tile), c);
+            return false;
+        }
+    m_figure.push_back(tile);
+    return true;
+}
+
+void Joint_Search::remove_tile(Point<int> tile)
+{
+    m_figure.pop_back();
+    for (auto c{m_placements.size()}; c-- > 0;)
+        release(m_placements[c](tile), c);
+}
+
+bool Joint_Search::place_copy(std::size_t copy, Placement const& place)
+{
+    for (std::size_t i{0}; i < m_figure.size(); ++i)
+        if (!claim(place(m_figure[i]), copy))
+        {
+            while (i-- > 0)
+                release(place(m_figure[i]), copy);
+            return false;
+        }
+    m_placements.push_back(place);
+    return true;
+}
+
+void Joint_Search::remove_copy(std::size_t copy)
+{
+    for (auto i{m_figure.size()}; i-- > 0;)
+        release(m_placements.back()(m_figure[i]), copy);
+    m_placements.pop_back();
+}
+
+bool Joint_Search::addable(Point<int> p) const
+{
+    for (auto const& place : m_placements)
+        if (auto i{index(place(p))}; i < m_first || m_owner[i] >= 0)
+            return false;
+    return true;
+}
+
+std::size_t Joint_Search::tiles_needed(std::vector<Point<int>> const& untried)
+{
+    auto const left{static_cast<int>(m_tiles - m_figure.size())};
+    auto touching{true};
+    for (std::size_t i{0}; i < m_placements.size(); ++i)
+        for (auto j{i + 1}; j < m_placements.size(); ++j)
+            touching = touching && m_contacts[i][j] > 0;
+    if (touching)
+        return 0;
+
+    // Find the fewest tiles that must be added to put each position in the figure. The
+    // untried positions are the only ones next to the figure that can be added, and
+    // beyond them only positions that haven't been offered. Each placed copy's tile at
+    // the position must be free.
+    m_reached = m_figure;
+    for (auto const& t : m_figure)
+        m_depth[index(t)] = 0;
+    for (auto const& p : untried)
+        if (left > 0 && addable(p))
+        {
+            m_depth[index(p)] = 1;
+            m_reached.push_back(p);
+        }
+    for (auto k{m_figure.size()}; k < m_reached.size(); ++k)
+    {
+        auto const p{m_reached[k]};
+        auto const depth{m_depth[index(p)]};
+        if (depth == left)
+            continue;
+        for (auto const& d : steps)
+            if (auto i{index(p + d)}; i >= 0 && !m_seen[i] && m_depth[i] < 0 && addable(p + d))
+            {
+                m_depth[i] = depth + 1;
+                m_reached.push_back(p + d);
+            }
+    }
+
+    // Two copies that don't touch need tiles that put them side by side.
+    auto needed{0};
+    for (std::size_t i{0}; i < m_placements.size() && needed <= left; ++i)
+        for (auto j{i + 1}; j < m_placements.size() && needed <= left; ++j)
+        {
+            if (m_contacts[i][j] > 0)
+                continue;
+            auto const back{inverse(m_placements[j])};
+            auto best{left + 1};
+            for (auto const& p : m_reached)
+                for (auto const& d : steps)
+                    if (auto q{index(back(m_placements[i](p) + d))}; q >= 0 && m_depth[q] >= 0)
+                        best = std::min(best, std::max(m_depth[index(p)], m_depth[q]));
+            needed = std::max(needed, best);
+        }
+
+    for (auto const& p : m_reached)
+        m_depth[index(p)] = -1;
+    return needed;
+}
+
+std::vector<Placement> const& Joint_Search::touching_unmoved(Point<int> tile)
+{
+    if (auto it{m_remembered.find(m_figure)}; it != m_remembered.end())
+        return it->second;
+
+    // Only the unmoved copy is in the way.
+    auto vacant{[this](Point<int> p) {
+        auto i{index(p)};
+        return i >= m_first && m_owner[i] != 0;
+    }};
+    // The copy mustn't have touched the unmoved copy before, or it would have been
+    // placed then. So its tiles, other than the new one, may be next to the unmoved copy
+    // only at the new tile.
+    auto touched_before{[this, tile](Point<int> p) {
+        auto next{std::abs(p.x - tile.x) + std::abs(p.y - tile.y) == 1};
+        return m_near[index(p)] > (next ? 1 : 0);
+    }};
+    std::vector<Point<int>> turned(m_figure.size());
+    std::vector<Placement> fits;
+    for (auto const& m : orientations)
+    {
+        Placement const turn{m, {0, 0}};
+        for (std::size_t k{0}; k < m_figure.size(); ++k)
+            turned[k] = turn(m_figure[k]);
+        ++m_stamp;
+        auto consider{[&](Point<int> offset) {
+            auto& stamp{m_offset_stamps[index(offset)]};
+            if (stamp == m_stamp)
+                return;
+            stamp = m_stamp;
+            for (std::size_t k{0}; k < m_figure.size(); ++k)
+                if (auto p{turned[k] + offset};
+                    !vacant(p) || (m_figure[k] != tile && touched_before(p)))
+                    return;
+            fits.push_back({m, offset});
+        }};
+        // Place the copy so that it touches the unmoved copy at the new tile: tile t of
+        // the copy next to the new tile, or the new tile of the copy next to t.
+        for (auto const& d : steps)
+        {
+            if (vacant(tile + d))
+                for (auto const& t : turned)
+                    consider(tile + d - t);
+            for (auto const& t : m_figure)
+                if (vacant(t + d))
+                    consider(t + d - turn(tile));
+        }
+    }
+    if (m_remembered.size() == max_remembered)
+    {
+        m_forgotten = std::move(fits);
+        return m_forgotten;
+    }
+    return m_remembered.emplace(m_figure, std::move(fits)).first->second;
+}
+
+std::vector<Placement> Joint_Search::candidates(Point<int> tile)
+{
+    // Each placed copy must be near enough to meet the new one with the tiles that are
+    // left. Copies that touch are a step apart, and each tile added brings two copies at
+    // most two steps closer.
+    auto const reach{2*static_cast<int>(m_tiles - m_figure.size()) + 1};
+    auto near_enough{[this, reach](Placement const& place, std::size_t copy) {
+        for (auto const& t : m_figure)
+            for (auto const& q : m_copy_tiles[copy])
+                if (auto p{place(t)}; std::abs(p.x - q.x) + std::abs(p.y - q.y) <= reach)
+                    return true;
+        return false;
+    }};
+    std::vector<Placement> fits;
+    for (auto const& place : touching_unmoved(tile))
+    {
+        auto fits_here{std::none_of(m_figure.begin(), m_figure.end(), [&](auto const& t) {
+            return m_owner[index(place(t))] >= 0;
+        })};
+        for (std::size_t c{1}; c < m_placements.size() && fits_here; ++c)
+            fits_here = near_enough(place, c);
+        // With no tiles left to add, the copy must touch the others already.
+        if (fits_here && (m_figure.size() < m_tiles || touches_placed(place)))
+            fits.push_back(place);
+    }
+    return fits;
+}
+
+bool Joint_Search::touches_placed(Placement const& place)
+{
+    m_touched.assign(m_placements.size(), false);
+    auto count{0u};
+    for (auto const& t : m_figure)
+        for (auto const& d : steps)
+            if (auto i{index(place(t) + d)}; i >= 0 && m_owner[i] >= 0 && !m_touched[m_owner[i]])
+            {
+                m_touched[m_owner[i]] = true;
+                if (++count == m_placements.size())
+                    return true;
+            }
+    return false;
+}
+
+bool Joint_Search::promising(std::vector<Point<int>> const& untried)
+{
+    return !m_done && m_control.visit(m_counter)
+        && m_figure.size() + tiles_needed(untried) <= m_tiles;
+}
+
+void Joint_Search::place_next(Point<int> tile, std::vector<Point<int>> const& untried)
+{
+    if (!promising(untried))
+        return;
+    extend(untried);
+    if (m_placements.size() < m_copy_tiles.size())
+        place_copies(tile, untried, candidates(tile), 0);
+}
+
+void Joint_Search::place_copies(Point<int> tile,
+                                std::vector<Point<int>> const& untried,
+                                std::vector<Placement> const& candidates,
+                                std::size_t first)
+{
+    auto const copy{m_placements.size()};
+    // Copies placed at the same tile are interchangeable, so take them in order.
+    for (auto c{first}; c < candidates.size() && !m_done; ++c)
+        if (place_copy(copy, candidates[c]))
+        {
+            if (promising(untried))
+            {
+                extend(untried);
+                if (copy + 1 < m_copy_tiles.size())
+                    place_copies(tile, untried, candidates, c + 1);
+            }
+            remove_copy(copy);
+        }
+}
+
+void Joint_Search::extend(std::vector<Point<int>> const& untried)
+{
+    if (m_figure.size() == m_tiles)
+    {
+        if (m_placements.size() < m_copy_tiles.size())
+            return;
+        for (std::size_t i{0}; i < m_placements.size(); ++i)
+            for (auto j{i + 1}; j < m_placements.size(); ++j)
+                if (m_contacts[i][j] == 0)
+                    return;
+        ++m_found;
+        m_done = m_report(Layout{Figure{Tile_List(m_figure.begin(), m_figure.end())},
+                                 m_placements});
+        return;
+    }
+    grow(untried);
+}
+
+void Joint_Search::grow(std::vector<Point<int>> untried)
+{
+    while (!untried.empty() && !m_done && !m_counter.stopped)
+    {
+        auto tile{untried.back()};
+        untried.pop_back();
+        if (!add_tile(tile))
+            continue;
+        // Offer the new tile's neighbors that haven't been offered, so that each figure
+        // is grown once.
+        auto next{untried};
+        for (auto const& d : steps)
+        {
+            auto p{tile + d};
+            if (!m_seen[index(p)])
+            {
+                m_seen[index(p)] = true;
+                next.push_back(p);
+            }
+        }
+        place_next(tile, next);
+        for (auto i{untried.size()}; i < next.size(); ++i)
+            m_seen[index(next[i])] = false;
+        remove_tile(tile);
+    }
+}
+
+Search_Stats grow_maps(std::size_t tiles,
+                       Layout_Handler const& handler,
+                       Joint_Options const& options)
+{
+    Search_Control control{options.limits};
+    Joint_Search search{tiles, options.copies, control, [&handler](Layout const& layout) {
+        handler(layout);
+        return false;
+    }};
+    search.run();
+    return control.stats(search.found(), control.stopped() ? 0.0 : 1.0);
+}
+
+Joint_Result smallest_map(Joint_Options const& options)
+{
+    Search_Control control{options.limits};
+    Joint_Result result;
+    for (std::size_t n{1}; n <= options.max_tiles && !result.layout && !control.stopped(); ++n)
+    {
+        Joint_Search search{n, options.copies, control, [&result](Layout const& layout) {
+            result.layout = layout;
+            return true;
+        }};
+        search.run();
+    }
+    result.stats = control.stats(result.layout ? 1 : 0, control.stopped() ? 0.0 : 1.0);
+    return result;
+}
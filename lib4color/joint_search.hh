@@ -0,0 +1,58 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_JOINT_SEARCH_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_JOINT_SEARCH_HH_INCLUDED
+
+#include "layout.hh"
+#include "search_control.hh"
+
+#include <functional>
+#include <optional>
+
+/// Called for each figure and map found.
+using Layout_Handler = std::function<void(Layout const& layout)>;
+
+struct Joint_Options
+{
+    /// The number of copies in a map.
+    std::size_t copies{4};
+    /// The largest figure that smallest_map() tries.
+    std::size_t max_tiles{10};
+    /// When to end the search early. A node is a tile added or a copy placed.
+    Search_Limits limits{};
+};
+
+/// Find figures of a given size together with their maps, without enumerating the
+/// figures first. The figure is grown a tile at a time, and each copy is placed when the
+/// tile that first makes it touch the unmoved copy is added. A branch is cut off when the
+/// copies that don't touch yet are too far apart to meet with the tiles that are left.
+/// A figure may be reported in more than one orientation, and a map more than once.
+/// @return The statistics of the search, including the number of maps reported.
+Search_Stats grow_maps(std::size_t tiles,
+                       Layout_Handler const& handler,
+                       Joint_Options const& options = {});
+
+struct Joint_Result
+{
+    /// A map of a figure with as few tiles as possible, if one was found.
+    std::optional<Layout> layout;
+    Search_Stats stats;
+};
+
+/// Look for a map with 1 tile, then 2, and so on up to options.max_tiles.
+Joint_Result smallest_map(Joint_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_JOINT_SEARCH_HH_INCLUDED
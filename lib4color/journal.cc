@@ -0,0 +1,173 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "journal.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/// The start of a journal file.
+struct Journal_Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+/// An edit as it's stored in the file. It has no padding, so every byte written is set.
+struct Journal_Record
+{
+    std::uint8_t type;
+    std::uint8_t all;
+    /// Zero when written. Older journals may have anything here.
+    std::uint16_t reserved;
+    std::int32_t x;
+    std::int32_t y;
+};
+
+static_assert(sizeof(Journal_Record) == 12
+              && std::has_unique_object_representations_v<Journal_Record>);
+
+constexpr char journal_magic[8]{'4', 'c', 'o', 'l', 'o', 'r', 'J', '\n'};
+constexpr std::uint32_t journal_version{1};
+
+/// Write all of the bytes, retrying after partial writes.
+/// @return False on error.
+bool write_all(int fd, void const* data, std::size_t size)
+{
+    auto bytes{static_cast<char const*>(data)};
+    while (size > 0)
+    {
+        auto n{::write(fd, bytes, size)};
+        if (n < 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+Journal::Journal(std::string const& file, std::chrono::milliseconds sync_interval)
+    : m_fd{::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)},
+      m_sync_interval{sync_interval}
+{
+    if (m_fd < 0)
+        throw std::runtime_error("Can't open journal " + file);
+    struct stat info;
+    if (::fstat(m_fd, &info) == 0 && info.st_size == 0)
+    {
+        Journal_Header header{};
+        std::memcpy(header.magic, journal_magic, sizeof(journal_magic));
+        header.version = journal_version;
+        write_all(m_fd, &header, sizeof(header));
+    }
+    m_worker = std::thread{&Journal::run, this};
+}
+
+Journal::~Journal()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_worker.join();
+    ::close(m_fd);
+}
+
+void Journal::append(Edit const& edit)
+{
+    std::lock_guard lock{m_mutex};
+    m_pending.push_back(edit);
+}
+
+void Journal::clear()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_pending.clear();
+        m_truncate = true;
+    }
+    m_wake.notify_one();
+}
+
+void Journal::run()
+{
+    std::vector<Edit> batch;
+    std::vector<Journal_Record> records;
+    std::unique_lock lock{m_mutex};
+    while (true)
+    {
+        m_wake.wait_for(lock, m_sync_interval, [this] { return m_stop || m_truncate; });
+        // Take the pending edits and leave an empty buffer with capacity for the next
+        // batch.
+        batch.swap(m_pending);
+        auto truncate{std::exchange(m_truncate, false)};
+        auto stop{m_stop};
+        lock.unlock();
+
+        auto ok{true};
+        auto changed{truncate || !batch.empty()};
+        if (truncate)
+            ok = ::ftruncate(m_fd, sizeof(Journal_Header)) == 0;
+        for (auto const& edit : batch)
+            records.push_back({static_cast<std::uint8_t>(edit.type), edit.all, 0,
+                               edit.arg.x, edit.arg.y});
+        if (ok && !records.empty())
+            ok = write_all(m_fd, records.data(), records.size()*sizeof(Journal_Record));
+        batch.clear();
+        records.clear();
+        // One sync for the whole batch.
+        if (ok && changed)
+            ok = ::fdatasync(m_fd) == 0;
+        if (!ok)
+            std::cerr << "Failed to write journal: " << std::strerror(errno) << std::endl;
+        if (stop)
+            return;
+        lock.lock();
+    }
+}
+
+std::vector<Edit> Journal::read(std::string const& file)
+{
+    std::ifstream is{file, std::ios::binary};
+    Journal_Header header{};
+    if (!is.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, journal_magic, sizeof(journal_magic)) != 0
+        || header.version != journal_version)
+        return {};
+
+    std::vector<Edit> edits;
+    Journal_Record record{};
+    while (is.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        // Edit_Type::reset is the last type.
+        if (record.type > static_cast<std::uint8_t>(Edit_Type::reset) || record.all > 1)
+            throw std::runtime_error("Bad edit in journal " + file + " at record "
+                                     + std::to_string(edits.size()));
+        edits.push_back({static_cast<Edit_Type>(record.type), record.all == 1,
+                         {record.x, record.y}});
+    }
+    return edits;
+}
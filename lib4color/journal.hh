@@ -0,0 +1,94 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_JOURNAL_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_JOURNAL_HH_INCLUDED
+
+#include "point.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// The kinds of changes a user can make to a map.
+enum class Edit_Type : std::uint8_t
+{
+    toggle,
+    translate,
+    rotate_ccw,
+    rotate_cw,
+    flip,
+    focus,
+    undo,
+    redo,
+    reset,
+};
+
+/// One change to a map. This is also the journal's record format.
+struct Edit
+{
+    Edit_Type type;
+    /// True if a transformation applies to all views instead of the focused one.
+    bool all{false};
+    /// The tile to toggle or the translation.
+    Point<int> arg{};
+};
+
+/// An append-only file of edits. Edits are written and synced to the disk in batches by
+/// a background thread, so append() doesn't wait for the disk.
+class Journal
+{
+public:
+    /// Open a journal for appending, creating the file if it doesn't exist.
+    /// @param sync_interval The longest time an edit waits before being written.
+    /// @throw std::runtime_error if the file can't be opened.
+    explicit Journal(std::string const& file,
+                     std::chrono::milliseconds sync_interval = std::chrono::milliseconds{200});
+    Journal(Journal const&) = delete;
+    Journal& operator=(Journal const&) = delete;
+    /// Write the remaining edits and close the file.
+    ~Journal();
+
+    /// Add an edit to the end of the journal.
+    void append(Edit const& edit);
+    /// Remove all edits from the journal, including those not yet written.
+    void clear();
+
+    /// @return The edits in a journal file. An incomplete last record is ignored. Empty
+    /// if the file doesn't exist.
+    /// @throw std::runtime_error if a record has an unknown edit type or flag.
+    static std::vector<Edit> read(std::string const& file);
+
+private:
+    /// Write batches of edits until stopped.
+    void run();
+
+    int m_fd{-1};
+    std::chrono::milliseconds m_sync_interval;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    /// Edits waiting to be written.
+    std::vector<Edit> m_pending;
+    /// True if the file should be emptied before writing pending edits.
+    bool m_truncate{false};
+    bool m_stop{false};
+    std::thread m_worker;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_JOURNAL_HH_INCLUDED
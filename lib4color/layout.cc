@@ -0,0 +1,131 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "layout.hh"
+
+#include <algorithm>
+
+Bounds bounds(Figure const& figure, Placement const& place)
+{
+    auto first{place(*figure.tiles().begin())};
+    Bounds box{first, first};
+    for (auto const& t : figure.tiles())
+        box.include(place(t));
+    return box;
+}
+
+Bounds bounds(Figure const& figure, std::vector<Placement> const& placements)
+{
+    auto box{bounds(figure, placements.front())};
+    for (auto const& place : placements)
+        box = box | bounds(figure, place);
+    return box;
+}
+
+std::optional<Placement> find_placement(Figure const& figure, std::vector<Point<int>> tiles)
+{
+    if (tiles.size() != figure.tiles().size() || tiles.empty())
+        return std::nullopt;
+
+    // Try each orientation. Match the smallest tiles to get the offset.
+    std::sort(tiles.begin(), tiles.end());
+    std::vector<Point<int>> oriented(tiles.size());
+    for (auto const& m : orientations)
+    {
+        Placement place{m, {0, 0}};
+        std::transform(figure.tiles().begin(), figure.tiles().end(), oriented.begin(), place);
+        std::sort(oriented.begin(), oriented.end());
+        place.offset = tiles.front() - oriented.front();
+        if (std::equal(oriented.begin(), oriented.end(), tiles.begin(),
+                       [&place](auto const& p, auto const& q) { return p + place.offset == q; }))
+            return place;
+    }
+    return std::nullopt;
+}
+
+/// @return The figure's tiles after applying @p place and moving the bounding box to
+/// (0, 0). The placement's offset is updated to include the move.
+std::vector<Point<int>> normalized(Figure const& figure, Placement& place)
+{
+    std::vector<Point<int>> tiles(figure.tiles().size());
+    std::transform(figure.tiles().begin(), figure.tiles().end(), tiles.begin(), place);
+    auto low{tiles.empty() ? Point<int>{} : bounds(figure, place).low};
+    for (auto& p : tiles)
+        p -= low;
+    place.offset -= low;
+    std::sort(tiles.begin(), tiles.end());
+    return tiles;
+}
+
+Canonical_Form canonical_form(Figure const& figure)
+{
+    Canonical_Form form;
+    for (auto i{0u}; i < orientations.size(); ++i)
+    {
+        Placement place{orientations[i], {0, 0}};
+        auto tiles{normalized(figure, place)};
+        if (i == 0 || tiles < form.tiles)
+            form = {std::move(tiles), place};
+    }
+    return form;
+}
+
+Placement to_canonical(Canonical_Form const& form, Placement const& place)
+{
+    return form.placement*place*inverse(form.placement);
+}
+
+Placement from_canonical(Canonical_Form const& form, Placement const& place)
+{
+    return inverse(form.placement)*place*form.placement;
+}
+
+std::uint64_t canonical_hash(Canonical_Form const& form)
+{
+    // FNV-1a over the coordinates. The hash is stored in files, so it must not depend on
+    // the platform.
+    std::uint64_t hash{0xcbf29ce484222325};
+    auto add{[&hash](int k) {
+        for (auto i{0}; i < 4; ++i)
+            hash = (hash ^ ((static_cast<std::uint32_t>(k) >> 8*i) & 0xff))*0x100000001b3;
+    }};
+    for (auto const& p : form.tiles)
+    {
+        add(p.x);
+        add(p.y);
+    }
+    return hash;
+}
+
+std::uint64_t canonical_hash(Figure const& figure)
+{
+    return canonical_hash(canonical_form(figure));
+}
+
+std::vector<Placement> symmetries(Figure const& figure)
+{
+    // Each orientation that gives the canonical tiles differs from the canonical
+    // placement by a symmetry.
+    auto form{canonical_form(figure)};
+    auto from_canonical{inverse(form.placement)};
+    std::vector<Placement> syms;
+    for (auto const& m : orientations)
+    {
+        Placement place{m, {0, 0}};
+        if (normalized(figure, place) == form.tiles)
+            syms.push_back(from_canonical*place);
+    }
+    return syms;
+}
@@ -0,0 +1,73 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_LAYOUT_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_LAYOUT_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// A figure and the placements of its copies. Unlike Figure_View, a layout owns its
+/// figure, so it can be copied and handed to another thread.
+struct Layout
+{
+    Figure figure;
+    std::vector<Placement> placements;
+};
+
+/// @return The bounds of the copies of a figure. The figure must have tiles, and there
+/// must be at least one copy.
+/// @{
+Bounds bounds(Figure const& figure, Placement const& place);
+Bounds bounds(Figure const& figure, std::vector<Placement> const& placements);
+/// @}
+
+/// @return A placement that puts the figure's tiles on @p tiles, if there is one.
+std::optional<Placement> find_placement(Figure const& figure, std::vector<Point<int>> tiles);
+
+/// A representation of a figure that's the same for all of its rotations, reflections,
+/// and translations.
+struct Canonical_Form
+{
+    /// The sorted tiles of the orientation that's lexicographically least when moved so
+    /// the bounding box starts at (0, 0).
+    std::vector<Point<int>> tiles;
+    /// The map from the figure's tiles to the canonical tiles.
+    Placement placement;
+};
+
+/// @return The figure's canonical form.
+Canonical_Form canonical_form(Figure const& figure);
+/// Move a copy's placement between the figure's frame and the canonical frame. In the
+/// canonical frame, the unmoved copy is the identity on the canonical tiles, so a map
+/// has the same placements wherever the figure was drawn.
+/// @{
+Placement to_canonical(Canonical_Form const& form, Placement const& place);
+Placement from_canonical(Canonical_Form const& form, Placement const& place);
+/// @}
+/// @return A hash of the canonical tiles. Figures that are copies of each other have the
+/// same hash.
+/// @{
+std::uint64_t canonical_hash(Canonical_Form const& form);
+std::uint64_t canonical_hash(Figure const& figure);
+/// @}
+/// @return The placements that map the figure onto itself, including the identity.
+std::vector<Placement> symmetries(Figure const& figure);
+
+#endif // FOUR_COLOR_LIB4COLOR_LAYOUT_HH_INCLUDED
@@ -0,0 +1,156 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "live_solver.hh"
+
+#include <iostream>
+
+/// The most maps waiting in each search thread's queue. More are counted but dropped.
+constexpr std::size_t queue_capacity{1024};
+/// The shortest time between notifications.
+constexpr std::chrono::milliseconds notify_interval{50};
+
+Live_Solver::Live_Solver(std::function<void()> notify, Solution_Cache* cache,
+                         std::size_t copies)
+    : m_notify{std::move(notify)},
+      m_cache{cache},
+      m_copies{copies}
+{
+    for (auto i{0u}; i < search_threads({}); ++i)
+        m_queues.push_back(std::make_unique<Spsc_Queue<Result>>(queue_capacity));
+    m_worker = std::thread{&Live_Solver::run, this};
+}
+
+Live_Solver::~Live_Solver()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+        m_search_stop.request_stop();
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+std::uint64_t Live_Solver::solve(Figure const& figure)
+{
+    std::uint64_t generation;
+    {
+        std::lock_guard lock{m_mutex};
+        m_pending = figure;
+        generation = ++m_generation;
+        m_search_stop.request_stop();
+    }
+    m_wake.notify_one();
+    return generation;
+}
+
+void Live_Solver::cancel()
+{
+    std::lock_guard lock{m_mutex};
+    m_pending.reset();
+    ++m_generation;
+    m_search_stop.request_stop();
+}
+
+Live_Status Live_Solver::status() const
+{
+    return {m_status_generation, m_percent, m_found, m_done};
+}
+
+std::vector<Solution> Live_Solver::take()
+{
+    std::vector<Solution> solutions;
+    auto generation{m_generation.load()};
+    for (auto& queue : m_queues)
+        while (auto result{queue->pop()})
+            if (result->generation == generation)
+                solutions.push_back(std::move(result->solution));
+    return solutions;
+}
+
+void Live_Solver::notify(bool force)
+{
+    if (!m_notify)
+        return;
+    auto now{std::chrono::steady_clock::now().time_since_epoch().count()};
+    auto last{m_last_notify.load()};
+    auto interval{std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            notify_interval).count()};
+    // Only one thread wins the exchange, so calls aren't repeated.
+    if (force || (now - last >= interval && m_last_notify.compare_exchange_strong(last, now)))
+    {
+        m_last_notify = now;
+        m_notify();
+    }
+}
+
+void Live_Solver::run()
+{
+    while (true)
+    {
+        std::unique_lock lock{m_mutex};
+        m_wake.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop)
+            return;
+        auto const figure{std::move(*m_pending)};
+        m_pending.reset();
+        auto generation{m_generation.load()};
+        m_search_stop = std::stop_source{};
+        auto stop{m_search_stop.get_token()};
+        lock.unlock();
+
+        m_percent = 0;
+        m_found = 0;
+        m_done = false;
+        m_status_generation = generation;
+
+        // Keep some maps for the cache.
+        std::mutex kept_mutex;
+        std::vector<Solution> kept;
+        auto handler{[&](unsigned thread, Solution const& solution) {
+            ++m_found;
+            m_queues[thread]->push({generation, solution});
+            if (m_cache)
+            {
+                std::lock_guard kept_lock{kept_mutex};
+                if (kept.size() < m_cache->max_solutions())
+                    kept.push_back(solution);
+            }
+            notify(false);
+        }};
+        auto progress{[&](double fraction) {
+            m_percent = static_cast<int>(100*fraction);
+            notify(false);
+        }};
+        try
+        {
+            auto stats{find_maps(figure, handler,
+                                 {m_copies, static_cast<unsigned>(m_queues.size()), true,
+                                  {stop}, progress})};
+            if (stats.complete())
+            {
+                m_done = true;
+                if (m_cache)
+                    m_cache->store(figure, stats.solutions, kept);
+            }
+        }
+        catch (std::exception const& error)
+        {
+            std::cerr << error.what() << std::endl;
+        }
+        notify(true);
+    }
+}
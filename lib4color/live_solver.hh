@@ -0,0 +1,115 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_LIVE_SOLVER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_LIVE_SOLVER_HH_INCLUDED
+
+#include "search.hh"
+#include "solution_cache.hh"
+#include "spsc_queue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+/// The state of the most recent search.
+struct Live_Status
+{
+    /// The search the rest of the members describe.
+    std::uint64_t generation{0};
+    int percent{0};
+    /// The number of maps found so far.
+    std::size_t found{0};
+    /// True if the search ran to the end.
+    bool done{false};
+};
+
+/// Searches for maps of a figure in the background, dropping the search in progress
+/// when a new figure is given. Maps pass to the consumer through a lock-free queue for
+/// each search thread, so neither side waits on the other.
+class Live_Solver
+{
+public:
+    /// @param notify Called from a search thread at most every few tens of milliseconds
+    /// while there is news, and when a search ends.
+    /// @param cache If not null, results of searches that run to the end are stored here.
+    /// It should hold only maps with @p copies copies.
+    /// @param copies The number of copies in a map.
+    explicit Live_Solver(std::function<void()> notify = {},
+                         Solution_Cache* cache = nullptr,
+                         std::size_t copies = 4);
+    /// Stop the current search and the worker.
+    ~Live_Solver();
+
+    /// Start searching a figure, stopping the search in progress.
+    /// @return The generation number of the new search.
+    std::uint64_t solve(Figure const& figure);
+    /// Stop the search in progress without starting another.
+    void cancel();
+
+    /// @return The state of the most recent search.
+    Live_Status status() const;
+    /// @return The maps found by the most recent search since the last call. Maps from
+    /// earlier searches are thrown away. Must be called from only one thread.
+    std::vector<Solution> take();
+
+private:
+    /// Do searches until stopped.
+    void run();
+    /// Call m_notify if it hasn't been called recently or if @p force is set.
+    void notify(bool force);
+
+    /// A map tagged with the search that found it.
+    struct Result
+    {
+        std::uint64_t generation;
+        Solution solution;
+    };
+
+    std::function<void()> m_notify;
+    Solution_Cache* m_cache;
+    std::size_t m_copies;
+    std::vector<std::unique_ptr<Spsc_Queue<Result>>> m_queues;
+    /// The generation of the most recent request.
+    std::atomic<std::uint64_t> m_generation{0};
+
+    /// The progress of the running search.
+    /// @{
+    std::atomic<std::uint64_t> m_status_generation{0};
+    std::atomic<int> m_percent{0};
+    std::atomic<std::size_t> m_found{0};
+    std::atomic<bool> m_done{false};
+    std::atomic<std::chrono::steady_clock::rep> m_last_notify{0};
+    /// @}
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<Figure> m_pending;
+    /// Stops the running search.
+    std::stop_source m_search_stop;
+    bool m_stop{false};
+    /// The worker is started last and stopped first.
+    std::thread m_worker;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_LIVE_SOLVER_HH_INCLUDED
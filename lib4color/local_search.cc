@@ -0,0 +1,257 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "local_search.hh"
+#include "bitboard.hh"
+#include "move_hints.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+/// @return The number of tiles that aren't in the largest edge-connected piece.
+std::size_t stray_tiles(Tile_List const& tiles)
+{
+    std::size_t largest{0};
+    for (auto const& piece : pieces(tiles))
+        largest = std::max(largest, piece.size());
+    return tiles.size() - largest;
+}
+
+std::size_t layout_cost(Layout const& layout)
+{
+    auto const& tiles{layout.figure.tiles()};
+    auto const k{layout.placements.size()};
+    if (tiles.empty())
+        return k*(k - 1)/2;
+    if (k == 0)
+        return 0;
+
+    // Find each view's bounding box and one that holds them all.
+    std::vector<Bounds> boxes;
+    for (auto const& place : layout.placements)
+        boxes.push_back(bounds(layout.figure, place));
+    auto all{boxes.front()};
+    for (auto const& box : boxes)
+        all = all | box;
+    auto origin{all.low - Point<int>{1, 1}};
+    auto size{all.high - all.low + Point<int>{3, 3}};
+    std::vector<Bitboard> boards;
+    for (auto const& place : layout.placements)
+    {
+        boards.emplace_back(size.x, size.y);
+        for (auto const& t : tiles)
+            boards.back().set(place(t) - origin);
+    }
+
+    // A stray tile is in every view, where it can make contacts that a contiguous
+    // figure can't, so it costs as much as a contact for each view.
+    auto cost{k*stray_tiles(tiles)};
+    for (std::size_t i{0}; i < k; ++i)
+        for (auto j{i + 1}; j < k; ++j)
+        {
+            // A missing contact costs more the farther apart the views' bounding boxes
+            // are, which gives the search a way toward it.
+            if (!boards[i].halo().intersects(boards[j]))
+                cost += 1 + std::max({0,
+                                      boxes[j].low.x - boxes[i].high.x - 1,
+                                      boxes[i].low.x - boxes[j].high.x - 1,
+                                      boxes[j].low.y - boxes[i].high.y - 1,
+                                      boxes[i].low.y - boxes[j].high.y - 1});
+            cost += (boards[i] & boards[j]).count();
+        }
+    return cost;
+}
+
+/// @return The placement after making one of single_moves() on a view. Rotations and
+/// flips keep the low corner of the view's bounding box in place.
+Placement move_view(Figure const& figure, Placement const& place, Edit const& move)
+{
+    auto turn{[&](Matrix const& m) {
+        auto turned{Placement{m, {0, 0}}*place};
+        turned.offset += bounds(figure, place).low - bounds(figure, turned).low;
+        return turned;
+    }};
+    switch (move.type)
+    {
+    case Edit_Type::translate:
+        return {place.transform, place.offset + move.arg};
+    case Edit_Type::rotate_ccw:
+        return turn(orientations[1]);
+    case Edit_Type::rotate_cw:
+        return turn(orientations[3]);
+    case Edit_Type::flip:
+        return turn(orientations[4]);
+    default:
+        return place;
+    }
+}
+
+/// The best layout found by any chain.
+struct Shared_Best
+{
+    std::mutex mutex;
+    Layout layout;
+    std::size_t cost;
+};
+
+Anneal_Result anneal(Layout const& start, Anneal_Options const& options)
+{
+    Search_Control control{options.limits};
+    Shared_Best shared{{}, start, layout_cost(start)};
+    if (shared.layout.figure.tiles().empty())
+        shared.layout.figure.toggle({0, 0});
+    shared.cost = layout_cost(shared.layout);
+    std::atomic<bool> solved{shared.cost == 0};
+
+    auto const size{shared.layout.figure.tiles().size()};
+    auto const min_tiles{std::max<std::size_t>(
+            options.min_tiles > 0 ? options.min_tiles : size, 1)};
+    auto const max_tiles{std::max(
+            options.max_tiles > 0 ? options.max_tiles : size, min_tiles)};
+    auto const moves{single_moves()};
+    auto const cooling{std::pow(options.end_temperature/options.start_temperature,
+                                1.0/std::max<std::uint64_t>(options.run_steps, 1))};
+
+    auto chain{[&](unsigned index) {
+        Search_Control::Counter counter;
+        std::mt19937_64 random{options.seed + index};
+        std::uniform_real_distribution<double> unit;
+        auto pick{[&random](int low, int high) {
+            return std::uniform_int_distribution<int>{low, high}(random);
+        }};
+
+        Layout layout;
+        std::size_t cost;
+        {
+            std::lock_guard lock{shared.mutex};
+            layout = shared.layout;
+            cost = shared.cost;
+        }
+        auto best{layout};
+        auto best_cost{cost};
+        std::deque<Point<int>> tabu;
+        auto temperature{options.start_temperature};
+        auto accept{[&](std::size_t new_cost) {
+            auto rise{static_cast<double>(new_cost) - static_cast<double>(cost)};
+            return new_cost <= cost || unit(random) < std::exp(-rise/temperature);
+        }};
+        // Give the shared best layout this chain's best, or take it if it's better.
+        auto exchange{[&] {
+            std::lock_guard lock{shared.mutex};
+            if (best_cost < shared.cost)
+            {
+                shared.layout = best;
+                shared.cost = best_cost;
+            }
+            else if (shared.cost < best_cost)
+            {
+                best = shared.layout;
+                best_cost = shared.cost;
+            }
+        }};
+        // Add a tile next to the figure or remove one. If that would take the number of
+        // tiles out of range, do the other as well, which moves a tile.
+        auto toggle{[&] {
+            auto const& tiles{layout.figure.tiles()};
+            auto random_tile{[&] {
+                return *std::next(tiles.begin(), pick(0, tiles.size() - 1));
+            }};
+            auto random_neighbor{[&] {
+                std::array<Point<int>, 4> const steps{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+                return random_tile() + steps[pick(0, 3)];
+            }};
+            auto add{unit(random) < 0.5};
+            std::vector<Point<int>> changed{add ? random_neighbor() : random_tile()};
+            if (add ? tiles.size() >= max_tiles : tiles.size() <= min_tiles)
+                changed.push_back(add ? random_tile() : random_neighbor());
+            for (auto const& p : changed)
+                if (std::find(tabu.begin(), tabu.end(), p) != tabu.end())
+                    return;
+            // Skip adding a tile that's there or removing one that's just been added.
+            if ((add && tiles.contains(changed[0]))
+                || (changed.size() > 1 && (tiles.contains(changed[1]) == add
+                                           || changed[0] == changed[1])))
+                return;
+            for (auto const& p : changed)
+                layout.figure.toggle(p);
+            if (auto new_cost{layout_cost(layout)};
+                !layout.figure.tiles().empty() && accept(new_cost))
+            {
+                cost = new_cost;
+                for (auto const& p : changed)
+                    tabu.push_back(p);
+                while (tabu.size() > options.tabu_tenure)
+                    tabu.pop_front();
+            }
+            else
+                for (auto const& p : changed)
+                    layout.figure.toggle(p);
+        }};
+        auto move{[&] {
+            auto& place{layout.placements[pick(0, layout.placements.size() - 1)]};
+            auto const old{place};
+            place = move_view(layout.figure, old, moves[pick(0, moves.size() - 1)]);
+            if (auto new_cost{layout_cost(layout)}; accept(new_cost))
+                cost = new_cost;
+            else
+                place = old;
+        }};
+
+        for (std::uint64_t step{1}; !solved && control.visit(counter); ++step)
+        {
+            if (unit(random) < options.toggle_rate || layout.placements.empty())
+                toggle();
+            else
+                move();
+            if (cost < best_cost)
+            {
+                best = layout;
+                best_cost = cost;
+                if (cost == 0)
+                    solved = true;
+            }
+            temperature *= cooling;
+            if (options.exchange_steps > 0 && step % options.exchange_steps == 0)
+                exchange();
+            if (options.run_steps > 0 && step % options.run_steps == 0)
+            {
+                // Start a new run from the best layout so far.
+                exchange();
+                layout = best;
+                cost = best_cost;
+                temperature = options.start_temperature;
+                tabu.clear();
+            }
+        }
+        exchange();
+        control.flush(counter);
+    }};
+
+    if (!solved)
+    {
+        std::vector<std::jthread> chains;
+        auto threads{default_threads(options.threads)};
+        for (auto t{0u}; t < threads; ++t)
+            chains.emplace_back(chain, t);
+    }
+    return {shared.layout, shared.cost,
+            control.stats(shared.cost == 0 ? 1 : 0, shared.cost == 0 ? 1.0 : 0.0)};
+}
@@ -0,0 +1,74 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_LOCAL_SEARCH_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_LOCAL_SEARCH_HH_INCLUDED
+
+#include "layout.hh"
+#include "search_control.hh"
+
+#include <cstdint>
+
+/// @return The cost of the missing contacts, the overlaps, and the disconnections of a
+/// layout. A pair of views that don't share an edge costs 1 plus the number of empty
+/// rows or columns between their bounding boxes. Each tile covered by two views costs 1.
+/// Each tile outside the largest piece of the figure costs the number of views, since
+/// it's in each of them. Zero for a map of a contiguous figure, or with no views.
+std::size_t layout_cost(Layout const& layout);
+
+struct Anneal_Options
+{
+    /// The number of independent chains, one per thread. Zero for one per core.
+    unsigned threads{0};
+    /// Toggles keep the number of tiles in this range. Zero for the number of tiles in
+    /// the starting figure. When a toggle would leave the range, another tile is toggled
+    /// the other way, which moves a tile.
+    std::size_t min_tiles{0};
+    std::size_t max_tiles{0};
+    /// The fraction of steps that toggle a tile. The rest move a view.
+    double toggle_rate{0.1};
+    /// The temperature falls geometrically from the first to the second over a run.
+    double start_temperature{0.5};
+    double end_temperature{0.05};
+    /// The number of steps in a run. Each chain restarts from the best layout found by
+    /// any chain after each run.
+    std::uint64_t run_steps{10000};
+    /// The number of most recently toggled tiles that may not be toggled again.
+    std::size_t tabu_tenure{8};
+    /// The number of steps between exchanges of the chains' best layouts.
+    std::uint64_t exchange_steps{2000};
+    /// The seed for the chains' random number generators.
+    std::uint64_t seed{0};
+    /// When to end the search early. A node is a step tried. The search also ends when a
+    /// layout with zero cost is found.
+    Search_Limits limits{};
+};
+
+/// The best layout found by anneal() and how the search went.
+struct Anneal_Result
+{
+    Layout best;
+    std::size_t cost;
+    Search_Stats stats;
+};
+
+/// Look for a map by simulated annealing. The steps are the edits of the grid: toggling a
+/// tile of the figure, which changes all the views, and moving, rotating, or flipping a
+/// view. Each chain has a tabu list of recently toggled tiles so it doesn't undo its
+/// changes to the figure right away. Without limits, the search goes on until it finds a
+/// map.
+Anneal_Result anneal(Layout const& start, Anneal_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_LOCAL_SEARCH_HH_INCLUDED
@@ -0,0 +1,163 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "move_hints.hh"
+#include "bitboard.hh"
+
+#include <algorithm>
+
+std::vector<Edit> single_moves()
+{
+    return {{Edit_Type::translate, false, {-1, 0}},
+            {Edit_Type::translate, false, {1, 0}},
+            {Edit_Type::translate, false, {0, 1}},
+            {Edit_Type::translate, false, {0, -1}},
+            {Edit_Type::rotate_ccw},
+            {Edit_Type::rotate_cw},
+            {Edit_Type::flip}};
+}
+
+/// Make a move the way Grid_Map does.
+void make_move(Figure_View& view, Edit const& move)
+{
+    switch (move.type)
+    {
+    case Edit_Type::translate:
+        view.translate(move.arg);
+        break;
+    case Edit_Type::rotate_ccw:
+        view.rotate_ccw();
+        break;
+    case Edit_Type::rotate_cw:
+        view.rotate_cw();
+        break;
+    case Edit_Type::flip:
+        view.flip_y();
+        break;
+    default:
+        break;
+    }
+}
+
+std::vector<Move_Hint> evaluate_moves(Layout const& layout, std::size_t focus)
+{
+    std::vector<Move_Hint> hints;
+    if (layout.figure.tiles().empty() || focus >= layout.placements.size())
+        return hints;
+
+    // Figure_View needs a figure it can change. It's not changed here.
+    auto figure{layout.figure};
+    for (auto const& move : single_moves())
+    {
+        Figure_View view(figure, {0, 0}, black);
+        view.place(layout.placements[focus]);
+        make_move(view, move);
+        hints.push_back({move, view.placement()});
+    }
+
+    // Make a board that holds every view and every moved view with a margin for halos.
+    auto const& tiles{figure.tiles()};
+    auto box{bounds(figure, layout.placements)};
+    for (auto const& hint : hints)
+        box = box | bounds(figure, hint.placement);
+    auto origin{box.low - Point<int>{1, 1}};
+    auto size{box.high - box.low + Point<int>{3, 3}};
+    auto board{[&](Placement const& place) {
+        Bitboard b(size.x, size.y);
+        for (auto const& t : tiles)
+            b.set(place(t) - origin);
+        return b;
+    }};
+
+    std::vector<Bitboard> others;
+    Bitboard all_others(size.x, size.y);
+    for (std::size_t v{0}; v < layout.placements.size(); ++v)
+        if (v != focus)
+        {
+            others.push_back(board(layout.placements[v]));
+            all_others |= others.back();
+        }
+    for (auto& hint : hints)
+    {
+        auto moved{board(hint.placement)};
+        auto halo{moved.halo()};
+        hint.touches = std::count_if(others.begin(), others.end(),
+                                     [&halo](auto const& b) { return halo.intersects(b); });
+        hint.overlaps = moved.intersects(all_others);
+    }
+    return hints;
+}
+
+Move_Hinter::Move_Hinter(std::function<void()> notify)
+    : m_notify{std::move(notify)},
+      m_worker{&Move_Hinter::run, this}
+{
+}
+
+Move_Hinter::~Move_Hinter()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+std::uint64_t Move_Hinter::request(Layout layout, std::size_t focus)
+{
+    std::uint64_t generation;
+    {
+        std::lock_guard lock{m_mutex};
+        m_pending = std::move(layout);
+        m_pending_focus = focus;
+        generation = ++m_generation;
+    }
+    m_wake.notify_one();
+    return generation;
+}
+
+std::optional<std::vector<Move_Hint>> Move_Hinter::hints(std::uint64_t generation) const
+{
+    std::lock_guard lock{m_mutex};
+    if (m_hints_generation != generation)
+        return std::nullopt;
+    return m_hints;
+}
+
+void Move_Hinter::run()
+{
+    while (true)
+    {
+        std::unique_lock lock{m_mutex};
+        m_wake.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop)
+            return;
+        auto const layout{std::move(*m_pending)};
+        auto focus{m_pending_focus};
+        auto generation{m_generation};
+        m_pending.reset();
+        lock.unlock();
+
+        auto hints{evaluate_moves(layout, focus)};
+
+        lock.lock();
+        m_hints = std::move(hints);
+        m_hints_generation = generation;
+        lock.unlock();
+        if (m_notify)
+            m_notify();
+    }
+}
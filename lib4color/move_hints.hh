@@ -0,0 +1,88 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_MOVE_HINTS_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_MOVE_HINTS_HH_INCLUDED
+
+#include "journal.hh"
+#include "layout.hh"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/// The outcome of moving one view a single step.
+struct Move_Hint
+{
+    /// The move: a translation by one tile, a rotation, or a flip.
+    Edit move;
+    /// The placement of the view after the move.
+    Placement placement;
+    /// The number of other views the moved view shares an edge with.
+    std::size_t touches{0};
+    /// True if the moved view covers a tile of another view.
+    bool overlaps{false};
+};
+
+/// The single-step moves of a view: the four translations, the two rotations, and the
+/// flip.
+std::vector<Edit> single_moves();
+
+/// Make one of the single-step moves on a view. Other edits are ignored.
+void make_move(Figure_View& view, Edit const& move);
+
+/// Score each single-step move of the view @p focus. The moves are made on a copy of the
+/// figure the same way Figure_View makes them, and contacts are found with bitboards.
+std::vector<Move_Hint> evaluate_moves(Layout const& layout, std::size_t focus);
+
+/// Evaluates moves on a background thread so they're ready before the next key press.
+/// Only the most recent request is kept while an evaluation is running.
+class Move_Hinter
+{
+public:
+    /// @param notify Called on the worker thread when hints are ready.
+    explicit Move_Hinter(std::function<void()> notify = {});
+    /// Stop the worker.
+    ~Move_Hinter();
+
+    /// Evaluate the moves of a view.
+    /// @return The generation number of the request.
+    std::uint64_t request(Layout layout, std::size_t focus);
+    /// @return The hints for the request with the given generation, if they're ready.
+    std::optional<std::vector<Move_Hint>> hints(std::uint64_t generation) const;
+
+private:
+    /// Evaluate requests until stopped.
+    void run();
+
+    std::function<void()> m_notify;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<Layout> m_pending;
+    std::size_t m_pending_focus{0};
+    std::uint64_t m_generation{0};
+    /// The most recent results and the request they're for.
+    std::vector<Move_Hint> m_hints;
+    std::uint64_t m_hints_generation{0};
+    bool m_stop{false};
+    /// The worker is started last and stopped first.
+    std::thread m_worker;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_MOVE_HINTS_HH_INCLUDED
@@ -0,0 +1,257 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "png_reader.hh"
+
+#include <png.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// The label of pixels that aren't close to a view color.
+constexpr std::uint8_t background{0};
+/// The largest squared RGB distance from a view color for a pixel to get its label.
+constexpr int max_color_distance2{3*40*40};
+
+/// @return 1 + the index of the view color nearest to the RGBA pixel, or background.
+std::uint8_t classify(png_byte const* pixel)
+{
+    if (pixel[3] < 128)
+        return background;
+    auto best{background};
+    auto best_d2{max_color_distance2 + 1};
+    for (std::size_t i{0}; i < view_colors.size(); ++i)
+    {
+        // Compare to the color as it would be written, i.e. with components clamped.
+        auto [r, g, b] = view_colors[i];
+        auto d = [](int c, png_byte p) { return std::clamp(c, 0, 255) - p; };
+        auto d2{d(r, pixel[0])*d(r, pixel[0])
+                + d(g, pixel[1])*d(g, pixel[1])
+                + d(b, pixel[2])*d(b, pixel[2])};
+        if (d2 < best_d2)
+        {
+            best_d2 = d2;
+            best = static_cast<std::uint8_t>(i + 1);
+        }
+    }
+    return best;
+}
+
+/// Accumulates the greatest common divisor of the lengths of colored runs of pixels, and
+/// the position of the first colored run.
+struct Run_Stats
+{
+    int pitch{0};
+    int phase{-1};
+
+    /// Note the end of a run of @p length pixels with the given label ending before
+    /// position @p end.
+    void add(std::uint8_t label, int length, int end)
+    {
+        if (label == background)
+            return;
+        pitch = std::gcd(pitch, length);
+        if (phase < 0)
+            phase = end - length;
+    }
+};
+
+/// The pixels of an image labeled by view color, and the runs of labels.
+struct Labeled_Image
+{
+    int w{0};
+    int h{0};
+    /// One byte per pixel: the index of the pixel's view color or background.
+    std::vector<std::uint8_t> labels;
+    Run_Stats rows;
+    Run_Stats columns;
+    /// The RGBA pixels of the whole image if it's interlaced, or of two rows.
+    std::vector<png_byte> rgba;
+    std::vector<png_bytep> row_pointers;
+    /// The row where the current vertical run started in each column.
+    std::vector<int> column_start;
+};
+
+/// Read and label the pixels. libpng reports errors by jumping back to the caller's
+/// setjmp(), which skips the destructors of this function's locals, so everything that
+/// owns memory is kept in @p image.
+void label_pixels(png_structp png, png_infop info, Labeled_Image& image)
+{
+    png_read_info(png, info);
+    // Convert everything to 8-bit RGBA.
+    png_set_expand(png);
+    png_set_strip_16(png);
+    png_set_gray_to_rgb(png);
+    png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+    auto passes{png_set_interlace_handling(png)};
+    png_read_update_info(png, info);
+    auto const w{static_cast<int>(png_get_image_width(png, info))};
+    auto const h{static_cast<int>(png_get_image_height(png, info))};
+    image.w = w;
+    image.h = h;
+    auto& labels{image.labels};
+    auto& rgba{image.rgba};
+
+    labels.resize(static_cast<std::size_t>(w)*h);
+    if (passes > 1)
+    {
+        // Interlaced rows aren't complete until the last pass. Read the whole image.
+        rgba.resize(4*labels.size());
+        image.row_pointers.resize(h);
+        for (auto y{0}; y < h; ++y)
+            image.row_pointers[y] = rgba.data() + 4*static_cast<std::size_t>(w)*y;
+        png_read_image(png, image.row_pointers.data());
+    }
+    else
+        rgba.resize(2*4*static_cast<std::size_t>(w));
+
+    auto& column_start{image.column_start};
+    column_start.assign(w, 0);
+    for (auto y{0}; y < h; ++y)
+    {
+        // Alternate between two row buffers so the previous row is available.
+        auto row_size{4*static_cast<std::size_t>(w)};
+        auto row{passes > 1 ? rgba.data() + row_size*y : rgba.data() + row_size*(y % 2)};
+        if (passes == 1)
+            png_read_row(png, row, nullptr);
+        auto label{labels.data() + static_cast<std::size_t>(w)*y};
+        // A row that's the same as the one above adds no new runs. Most rows of an image
+        // of tiles are like this.
+        if (y > 0 && std::equal(row, row + row_size,
+                                passes > 1 ? row - row_size
+                                : rgba.data() + row_size*((y + 1) % 2)))
+        {
+            std::copy_n(label - w, w, label);
+            continue;
+        }
+        // Flat images have long runs of identical pixels. Classify only on change.
+        std::uint32_t last_pixel{0};
+        for (auto x{0}; x < w; ++x)
+        {
+            std::uint32_t pixel;
+            std::copy_n(row + 4*x, 4, reinterpret_cast<png_byte*>(&pixel));
+            label[x] = (x > 0 && pixel == last_pixel) ? label[x - 1] : classify(row + 4*x);
+            last_pixel = pixel;
+        }
+        if (y > 0 && std::equal(label, label + w, label - w))
+            continue;
+        auto start{0};
+        for (auto x{1}; x <= w; ++x)
+            if (x == w || label[x] != label[start])
+            {
+                image.rows.add(label[start], x - start, x);
+                start = x;
+            }
+        if (y > 0)
+            for (auto x{0}; x < w; ++x)
+                if (label[x] != label[x - w])
+                {
+                    image.columns.add(label[x - w], y - column_start[x], y);
+                    column_start[x] = y;
+                }
+    }
+    for (auto x{0}; x < w; ++x)
+        image.columns.add(labels[static_cast<std::size_t>(w)*(h - 1) + x],
+                          h - column_start[x], h);
+}
+
+/// @return False if libpng reported an error while reading the image into @p image. No
+/// local of this function changes after setjmp(), so none is left indeterminate by the
+/// jump.
+bool read_labels(png_structp png, png_infop info, std::FILE* in, Labeled_Image& image)
+{
+    // libpng jumps back here on errors.
+    if (setjmp(png_jmpbuf(png)))
+        return false;
+    png_init_io(png, in);
+    png_set_sig_bytes(png, 8);
+    label_pixels(png, info, image);
+    return true;
+}
+
+Layout read_png(std::string const& file)
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> in{std::fopen(file.c_str(), "rb"),
+                                                         &std::fclose};
+    if (!in)
+        throw std::runtime_error("Can't open " + file);
+    png_byte signature[8];
+    if (std::fread(signature, 1, 8, in.get()) != 8 || png_sig_cmp(signature, 0, 8) != 0)
+        throw std::runtime_error(file + " is not a PNG file");
+
+    auto png{png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr)};
+    if (!png)
+        throw std::runtime_error("Can't start reading " + file);
+    auto info{png_create_info_struct(png)};
+    if (!info)
+    {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        throw std::runtime_error("Can't start reading " + file);
+    }
+    Labeled_Image image;
+    auto const read{read_labels(png, info, in.get(), image)};
+    png_destroy_read_struct(&png, &info, nullptr);
+    if (!read)
+        throw std::runtime_error("Failed to read " + file);
+
+    auto const w{image.w};
+    auto const h{image.h};
+    auto const& labels{image.labels};
+    auto const& rows{image.rows};
+    auto const& columns{image.columns};
+    if (rows.pitch == 0 || columns.pitch == 0)
+        throw std::runtime_error(file + " has no tiles");
+
+    // Sample the center of each cell. Cells are square, so take the common pitch.
+    auto pitch{std::gcd(rows.pitch, columns.pitch)};
+    auto x0{rows.phase % pitch};
+    auto y0{columns.phase % pitch};
+    auto num_columns{(w - x0)/pitch};
+    auto num_rows{(h - y0)/pitch};
+    std::vector<std::vector<Point<int>>> tiles(view_colors.size());
+    for (auto j{0}; j < num_rows; ++j)
+    {
+        auto label{labels.data() + static_cast<std::size_t>(w)*(y0 + j*pitch + pitch/2)};
+        for (auto i{0}; i < num_columns; ++i)
+            if (auto l{label[x0 + i*pitch + pitch/2]}; l != background)
+                tiles[l - 1].push_back({i, num_rows - 1 - j});
+    }
+
+    if (tiles.front().empty())
+        throw std::runtime_error(file + " has no tiles of the first color");
+    // The views' colors are used in order, so only colors after the last view's can be
+    // missing. A gap would put the later copies on the wrong views.
+    while (tiles.back().empty())
+        tiles.pop_back();
+    Layout layout{Figure{Tile_List{tiles.front().begin(), tiles.front().end()}}, {}};
+    for (std::size_t v{0}; v < tiles.size(); ++v)
+    {
+        auto const& copy{tiles[v]};
+        if (copy.empty())
+            throw std::runtime_error(file + " has no copy in the color of view "
+                                     + std::to_string(v + 1));
+        auto place{find_placement(layout.figure, copy)};
+        if (!place)
+            throw std::runtime_error(file + " has a figure that's not a copy of the first");
+        layout.placements.push_back(*place);
+    }
+    return layout;
+}
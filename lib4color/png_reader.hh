@@ -0,0 +1,34 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_PNG_READER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_PNG_READER_HH_INCLUDED
+
+#include "layout.hh"
+
+#include <string>
+
+/// Read an image of copies of a figure, such as one written by write_png(). Pixels close
+/// to one of the view colors are that view's. Anything else is background. The tile size
+/// and the position of the grid are found from the lengths and positions of the runs of
+/// colored pixels. The tiles of the first view color become the figure, and each of the
+/// following colors up to the last one present gets a placement. Tile (0, 0) is the
+/// lower-left cell of the image.
+/// @throw std::runtime_error if the file can't be read, there are no tiles of the first
+/// view color, a color before the last one present is missing, or the tiles of another
+/// color aren't a copy of the first.
+Layout read_png(std::string const& file);
+
+#endif // FOUR_COLOR_LIB4COLOR_PNG_READER_HH_INCLUDED
@@ -0,0 +1,118 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "ranking.hh"
+#include "contact.hh"
+#include "holes.hh"
+#include "layout.hh"
+
+#include <algorithm>
+#include <queue>
+#include <set>
+
+double compactness(Figure const& figure, Solution const& solution)
+{
+    return -static_cast<double>(map_area(figure, solution));
+}
+
+double shared_edges(Figure const& figure, Solution const& solution)
+{
+    return total_contact(contact_matrix(figure, solution));
+}
+
+double contact_strength(Figure const& figure, Solution const& solution)
+{
+    return weakest_contact(contact_matrix(figure, solution));
+}
+
+double symmetry(Figure const& figure, Solution const& solution)
+{
+    if (figure.tiles().empty() || solution.empty())
+        return 1;
+    // Each turn of the copies is moved so its bounding box starts at the origin.
+    auto copies{[&](Matrix const& m) {
+        Placement turn{m, {0, 0}};
+        std::vector<Placement> turned;
+        for (auto const& place : solution)
+            turned.push_back(turn*place);
+        auto low{bounds(figure, turned).low};
+        std::vector<std::vector<Point<int>>> tiles;
+        for (auto const& place : turned)
+        {
+            tiles.emplace_back();
+            for (auto const& t : figure.tiles())
+                tiles.back().push_back(place(t));
+        }
+        std::set<std::vector<Point<int>>> result;
+        for (auto& copy : tiles)
+        {
+            for (auto& p : copy)
+                p = p - low;
+            std::sort(copy.begin(), copy.end());
+            result.insert(copy);
+        }
+        return result;
+    }};
+    auto const original{copies(orientations[0])};
+    return std::count_if(orientations.begin(), orientations.end(), [&](Matrix const& m) {
+        return copies(m) == original;
+    });
+}
+
+double openness(Figure const& figure, Solution const& solution)
+{
+    std::size_t area{0};
+    for (auto const& hole : find_holes(figure, solution))
+        area += hole.tiles.size();
+    return -static_cast<double>(area);
+}
+
+Ranking top_maps(Figure const& figure,
+                 std::size_t count,
+                 Map_Metric const& metric,
+                 Search_Options const& options)
+{
+    // A min-heap on score, so the worst of the best is on top to be replaced.
+    auto worse{[](Ranked_Map const& a, Ranked_Map const& b) {
+        return a.score > b.score;
+    }};
+    using Heap = std::priority_queue<Ranked_Map, std::vector<Ranked_Map>, decltype(worse)>;
+    std::vector<Heap> heaps(search_threads(options), Heap{worse});
+
+    Ranking ranking;
+    ranking.stats = find_maps(figure, [&](unsigned thread, Solution const& solution) {
+        if (count == 0)
+            return;
+        auto& heap{heaps[thread]};
+        auto score{metric(figure, solution)};
+        if (heap.size() < count)
+            heap.push({solution, score});
+        else if (score > heap.top().score)
+        {
+            heap.pop();
+            heap.push({solution, score});
+        }
+    }, options);
+
+    for (auto& heap : heaps)
+        for (; !heap.empty(); heap.pop())
+            ranking.maps.push_back(heap.top());
+    std::stable_sort(ranking.maps.begin(), ranking.maps.end(), [](auto const& a, auto const& b) {
+        return a.score > b.score;
+    });
+    if (ranking.maps.size() > count)
+        ranking.maps.resize(count);
+    return ranking;
+}
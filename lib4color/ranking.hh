@@ -0,0 +1,69 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_RANKING_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_RANKING_HH_INCLUDED
+
+#include "figure.hh"
+#include "search.hh"
+
+#include <functional>
+#include <vector>
+
+/// Rates a map. Higher scores are better. Called from the search threads, so it must be
+/// safe to call concurrently.
+using Map_Metric = std::function<double(Figure const& figure, Solution const& solution)>;
+
+/// Metrics for ranking maps.
+/// @{
+/// @return The negated area of the map's bounding box, so that compact maps rank first.
+double compactness(Figure const& figure, Solution const& solution);
+/// @return The number of edges shared by tiles of different copies. Copies with long
+/// borders are easier to see as touching.
+double shared_edges(Figure const& figure, Solution const& solution);
+/// @return The fewest edges shared by any pair of copies. Maps whose copies all share
+/// long borders are the most robust.
+double contact_strength(Figure const& figure, Solution const& solution);
+/// @return The number of rotations and reflections that map the copies onto themselves,
+/// from 1 for no symmetry to 8.
+double symmetry(Figure const& figure, Solution const& solution);
+/// @return The negated number of empty tiles enclosed by the copies, so that maps with no
+/// interior region rank first.
+double openness(Figure const& figure, Solution const& solution);
+/// @}
+
+struct Ranked_Map
+{
+    Solution solution;
+    double score;
+};
+
+/// The best maps found by a search and how it went.
+struct Ranking
+{
+    /// The maps with the highest scores, best first.
+    std::vector<Ranked_Map> maps;
+    Search_Stats stats;
+};
+
+/// Like collect_maps(), but keep only the @p count maps with the highest scores. Each
+/// thread keeps its own bounded heap, and the heaps are merged at the end, so memory
+/// doesn't grow with the number of maps found.
+Ranking top_maps(Figure const& figure,
+                 std::size_t count,
+                 Map_Metric const& metric,
+                 Search_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_RANKING_HH_INCLUDED
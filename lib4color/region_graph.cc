@@ -0,0 +1,219 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "region_graph.hh"
+#include "contact.hh"
+#include "holes.hh"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+/// The state of a search for a coloring with the fewest colors.
+class Coloring
+{
+public:
+    /// @param neighbors The neighbors of each vertex.
+    /// @param empty Vertices that aren't branched on. Each is given by its neighbors,
+    /// which must be among the branched-on vertices, and none are neighbors of another.
+    Coloring(std::vector<std::uint64_t> const& neighbors,
+             std::vector<std::uint64_t> const& empty);
+    /// @return The fewest colors needed.
+    std::size_t solve();
+
+private:
+    /// @return The set of colors of the colored vertices in a mask.
+    std::uint64_t colors_of(std::uint64_t mask) const;
+    /// @return A lower bound on the colors needed to finish the current coloring, which
+    /// already uses @p used colors. Exact when all vertices are colored.
+    std::size_t bound(std::size_t used) const;
+    /// @return The size of a clique found greedily.
+    std::size_t clique() const;
+    /// Color the remaining vertices.
+    void extend(std::size_t used);
+
+    std::vector<std::uint64_t> const& m_neighbors;
+    std::vector<std::uint64_t> m_empty;
+    /// The color of each vertex.
+    std::vector<int> m_colors;
+    /// The vertices that have a color.
+    std::uint64_t m_colored{0};
+    std::uint64_t m_all;
+    /// The fewest colors in a complete coloring so far.
+    std::size_t m_best;
+    /// A number of colors that can't be beaten.
+    std::size_t m_lower{0};
+};
+
+Coloring::Coloring(std::vector<std::uint64_t> const& neighbors,
+                   std::vector<std::uint64_t> const& empty)
+    : m_neighbors{neighbors},
+      m_colors(neighbors.size(), -1),
+      m_all{neighbors.size() >= 64 ? ~std::uint64_t{0}
+            : (std::uint64_t{1} << neighbors.size()) - 1},
+      // Every vertex in its own color, and one more for the empty regions.
+      m_best{neighbors.size() + (empty.empty() ? 0 : 1)}
+{
+    if (neighbors.size() > 64)
+        throw std::runtime_error("Too many vertices to color: "
+                                 + std::to_string(neighbors.size()));
+    // An empty region whose copies are among another's adds nothing.
+    auto sorted{empty};
+    std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) {
+        return std::popcount(a) > std::popcount(b);
+    });
+    for (auto mask : sorted)
+        if (std::none_of(m_empty.begin(), m_empty.end(),
+                         [mask](auto other) { return (mask & other) == mask; }))
+            m_empty.push_back(mask);
+}
+
+std::size_t Coloring::solve()
+{
+    m_lower = clique();
+    if (!m_empty.empty())
+        m_lower = std::max<std::size_t>(m_lower, 1);
+    if (m_best > m_lower)
+        extend(0);
+    return m_best;
+}
+
+std::uint64_t Coloring::colors_of(std::uint64_t mask) const
+{
+    std::uint64_t colors{0};
+    for (mask &= m_colored; mask != 0; mask &= mask - 1)
+        colors |= std::uint64_t{1} << m_colors[std::countr_zero(mask)];
+    return colors;
+}
+
+std::size_t Coloring::bound(std::size_t used) const
+{
+    for (auto mask : m_empty)
+        used = std::max<std::size_t>(used, std::popcount(colors_of(mask)) + 1);
+    return used;
+}
+
+std::size_t Coloring::clique() const
+{
+    // Add the candidate with the most neighbors among the candidates, and keep its
+    // neighbors as the new candidates.
+    std::size_t size{0};
+    for (auto candidates{m_all}; candidates != 0; ++size)
+    {
+        auto best{std::countr_zero(candidates)};
+        auto best_degree{-1};
+        for (auto rest{candidates}; rest != 0; rest &= rest - 1)
+        {
+            auto v{std::countr_zero(rest)};
+            if (auto degree{std::popcount(m_neighbors[v] & candidates)};
+                degree > best_degree)
+            {
+                best = v;
+                best_degree = degree;
+            }
+        }
+        candidates &= m_neighbors[best];
+    }
+    return size;
+}
+
+void Coloring::extend(std::size_t used)
+{
+    if (bound(used) >= m_best)
+        return;
+    if (m_colored == m_all)
+    {
+        m_best = bound(used);
+        return;
+    }
+
+    // Pick the vertex with the most colors among its neighbors. Break ties with the
+    // number of uncolored neighbors.
+    auto vertex{0};
+    auto best_saturation{-1};
+    auto best_degree{-1};
+    for (auto rest{m_all & ~m_colored}; rest != 0; rest &= rest - 1)
+    {
+        auto v{std::countr_zero(rest)};
+        auto saturation{std::popcount(colors_of(m_neighbors[v]))};
+        auto degree{std::popcount(m_neighbors[v] & ~m_colored & m_all)};
+        if (saturation > best_saturation
+            || (saturation == best_saturation && degree > best_degree))
+        {
+            vertex = v;
+            best_saturation = saturation;
+            best_degree = degree;
+        }
+    }
+
+    // Try each color in use that no neighbor has, then one new color.
+    auto taken{colors_of(m_neighbors[vertex])};
+    auto const bit{std::uint64_t{1} << vertex};
+    m_colored |= bit;
+    for (std::size_t c{0}; c <= used && m_best > m_lower; ++c)
+    {
+        if (taken & (std::uint64_t{1} << c))
+            continue;
+        m_colors[vertex] = c;
+        extend(std::max(used, c + 1));
+    }
+    m_colored &= ~bit;
+    m_colors[vertex] = -1;
+}
+
+Region_Graph region_graph(Figure const& figure, std::vector<Placement> const& placements)
+{
+    if (placements.size() > 64)
+        throw std::runtime_error("Too many copies for a region graph: "
+                                 + std::to_string(placements.size()));
+    if (figure.tiles().empty())
+        return {};
+    return region_graph(contact_matrix(figure, placements),
+                        empty_regions(figure, placements));
+}
+
+Region_Graph region_graph(Contact_Matrix const& contacts, std::vector<Hole> const& regions)
+{
+    if (contacts.size() > 64)
+        throw std::runtime_error("Too many copies for a region graph: "
+                                 + std::to_string(contacts.size()));
+
+    Region_Graph graph;
+    for (std::size_t i{0}; i < contacts.size(); ++i)
+    {
+        graph.copies.push_back(0);
+        for (std::size_t j{0}; j < contacts.size(); ++j)
+            if (contacts[i][j] > 0)
+                graph.copies.back() |= std::uint64_t{1} << j;
+    }
+    for (auto const& region : regions)
+    {
+        graph.empty.push_back(0);
+        for (auto c : region.copies)
+            graph.empty.back() |= std::uint64_t{1} << c;
+    }
+    return graph;
+}
+
+std::size_t chromatic_number(std::vector<std::uint64_t> const& neighbors)
+{
+    return Coloring{neighbors, {}}.solve();
+}
+
+std::size_t chromatic_number(Region_Graph const& graph)
+{
+    return Coloring{graph.copies, graph.empty}.solve();
+}
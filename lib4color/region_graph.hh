@@ -0,0 +1,60 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_REGION_GRAPH_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_REGION_GRAPH_HH_INCLUDED
+
+#include "contact.hh"
+#include "figure.hh"
+#include "figure_view.hh"
+#include "holes.hh"
+
+#include <cstdint>
+#include <vector>
+
+/// The regions of a map and which ones share an edge. The regions are the copies of a
+/// figure, the holes they enclose, and the outside. Empty regions never touch each other,
+/// so each one is described by the copies around it, and there may be any number of
+/// them.
+struct Region_Graph
+{
+    /// For each copy, a bit mask of the other copies it shares an edge with.
+    std::vector<std::uint64_t> copies;
+    /// For each empty region, a bit mask of the copies it shares an edge with. The first
+    /// is the outside and the rest are holes.
+    std::vector<std::uint64_t> empty;
+};
+
+/// @return The region graph of copies of a figure.
+/// @throw std::runtime_error if there are more than 64 copies.
+Region_Graph region_graph(Figure const& figure, std::vector<Placement> const& placements);
+/// @return The region graph from the copies' contacts and the empty regions as found by
+/// contact_matrix() and empty_regions().
+/// @throw std::runtime_error if there are more than 64 copies.
+Region_Graph region_graph(Contact_Matrix const& contacts, std::vector<Hole> const& regions);
+
+/// @return The fewest colors that give neighbors different colors in a graph of up to 64
+/// vertices. Element i of @p neighbors is a bit mask of vertex i's neighbors. Found by
+/// DSATUR branch and bound: the vertex with the most differently colored neighbors is
+/// colored next, and a branch is dropped when it can't beat the best coloring so far.
+/// @throw std::runtime_error if there are more than 64 vertices.
+std::size_t chromatic_number(std::vector<std::uint64_t> const& neighbors);
+
+/// @return The fewest colors needed for the map, counting the holes and the outside as
+/// regions. Only the copies are branched on. An empty region needs a color that none of
+/// its copies has, so it costs an extra color only when its copies use all of them.
+std::size_t chromatic_number(Region_Graph const& graph);
+
+#endif // FOUR_COLOR_LIB4COLOR_REGION_GRAPH_HH_INCLUDED
@@ -0,0 +1,346 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "render.hh"
+#include "search_control.hh"
+
+#include <cairomm/surface.h>
+#include <png.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+/// @return A color as a pixel value for an ARGB32 image surface.
+std::uint32_t to_pixel(Color const& color)
+{
+    auto [r, g, b] = color;
+    auto clamp = [](int c) { return static_cast<std::uint32_t>(std::clamp(c, 0, 255)); };
+    return 0xff000000 | clamp(r) << 16 | clamp(g) << 8 | clamp(b);
+}
+
+/// @return The order to draw the views in.
+std::vector<std::size_t> draw_order(std::size_t num_views, std::size_t top)
+{
+    std::vector<std::size_t> order;
+    for (std::size_t i{0}; i < num_views; ++i)
+        if (i != top)
+            order.push_back(i);
+    if (top < num_views)
+        order.push_back(top);
+    return order;
+}
+
+/// Draw each tile as a filled rectangle.
+void draw_tiles(Cairo::RefPtr<Cairo::Context> const& cr,
+                Figure const& figure,
+                std::vector<Placement> const& views,
+                Frame const& frame,
+                double scale,
+                std::size_t top)
+{
+    // Put tile coordinates in user space with y increasing upward.
+    auto m1{cr->get_matrix()};
+    cr->translate(0, frame.height*scale);
+    cr->scale(scale, -scale);
+    cr->translate(-frame.origin.x, -frame.origin.y);
+    for (auto i : draw_order(views.size(), top))
+    {
+        set_color(cr, view_colors[i % view_colors.size()]);
+        for (auto const& tile : figure.tiles())
+        {
+            auto p{views[i](tile)};
+            cr->rectangle(p.x, p.y, 1, 1);
+        }
+        cr->fill();
+    }
+    cr->set_matrix(m1);
+}
+
+/// Set the pixel under the center of each tile in an image and paint the image.
+/// @param image Replaced by a new image if it's null or the wrong size.
+void draw_pixels(Cairo::RefPtr<Cairo::Context> const& cr,
+                 Figure const& figure,
+                 std::vector<Placement> const& views,
+                 Frame const& frame,
+                 double scale,
+                 std::size_t top,
+                 Cairo::RefPtr<Cairo::ImageSurface>& image)
+{
+    auto w{static_cast<int>(std::ceil(frame.width*scale))};
+    auto h{static_cast<int>(std::ceil(frame.height*scale))};
+    if (!image || image->get_width() != w || image->get_height() != h)
+        image = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w, h);
+    image->flush();
+    auto data{image->get_data()};
+    auto stride{image->get_stride()};
+    std::fill(data, data + stride*h, 0);
+
+    // The pixel position of the center of the tile at the origin.
+    auto x0{(0.5 - frame.origin.x)*scale};
+    auto y0{(frame.origin.y + frame.height - 0.5)*scale};
+    for (auto i : draw_order(views.size(), top))
+    {
+        auto pixel{to_pixel(view_colors[i % view_colors.size()])};
+        auto const& place{views[i]};
+        for (auto const& tile : figure.tiles())
+        {
+            auto p{place(tile)};
+            auto x{static_cast<int>(std::floor(x0 + p.x*scale))};
+            auto y{static_cast<int>(std::floor(y0 - p.y*scale))};
+            if (x >= 0 && x < w && y >= 0 && y < h)
+                reinterpret_cast<std::uint32_t*>(data + y*stride)[x] = pixel;
+        }
+    }
+    image->mark_dirty();
+    cr->set_source(image, 0, 0);
+    cr->paint();
+}
+
+/// The fraction of write_png()'s time assumed to be spent drawing. The rest is encoding.
+constexpr double draw_fraction{0.2};
+
+/// Encode the rows of an ARGB32 image. libpng reports errors by jumping back to the
+/// caller's setjmp(), which skips the destructors of this function's locals, so the row
+/// buffer is passed in.
+void write_rows(png_structp png, png_infop info,
+                Cairo::RefPtr<Cairo::ImageSurface> const& image,
+                std::vector<png_byte>& row,
+                Progress const& progress)
+{
+    auto w{image->get_width()};
+    auto h{image->get_height()};
+    auto data{image->get_data()};
+    auto stride{image->get_stride()};
+    png_set_IHDR(png, info, w, h, 8, PNG_COLOR_TYPE_RGBA, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (auto y{0}; y < h; ++y)
+    {
+        // Cairo's pixels are native-endian words with premultiplied alpha.
+        auto pixels{reinterpret_cast<std::uint32_t const*>(data + y*stride)};
+        for (auto x{0}; x < w; ++x)
+        {
+            auto a{pixels[x] >> 24};
+            auto unmultiply = [a](std::uint32_t c) {
+                return static_cast<png_byte>(a == 0 ? 0 : (255*(c & 0xff) + a/2)/a);
+            };
+            row[4*x] = unmultiply(pixels[x] >> 16);
+            row[4*x + 1] = unmultiply(pixels[x] >> 8);
+            row[4*x + 2] = unmultiply(pixels[x]);
+            row[4*x + 3] = static_cast<png_byte>(a);
+        }
+        png_write_row(png, row.data());
+        if (progress)
+            progress(draw_fraction + (1.0 - draw_fraction)*(y + 1)/h);
+    }
+    png_write_end(png, nullptr);
+}
+
+/// @return False if libpng reported an error while writing the image. No local of this
+/// function changes after setjmp(), so none is left indeterminate by the jump.
+bool write_image(png_structp png, png_infop info, std::FILE* out,
+                 Cairo::RefPtr<Cairo::ImageSurface> const& image,
+                 std::vector<png_byte>& row,
+                 Progress const& progress)
+{
+    // libpng jumps back here on errors.
+    if (setjmp(png_jmpbuf(png)))
+        return false;
+    png_init_io(png, out);
+    write_rows(png, info, image, row, progress);
+    return true;
+}
+
+/// Write an ARGB32 image as an 8-bit RGBA PNG file.
+void encode_png(Cairo::RefPtr<Cairo::ImageSurface> const& image,
+                std::string const& file,
+                Progress const& progress)
+{
+    image->flush();
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> out{std::fopen(file.c_str(), "wb"),
+                                                          &std::fclose};
+    if (!out)
+        throw std::runtime_error("Can't open " + file + " for writing");
+    auto png{png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr)};
+    if (!png)
+        throw std::runtime_error("Can't start writing " + file);
+    auto info{png_create_info_struct(png)};
+    if (!info)
+    {
+        png_destroy_write_struct(&png, nullptr);
+        throw std::runtime_error("Can't start writing " + file);
+    }
+    std::vector<png_byte> row(4*static_cast<std::size_t>(image->get_width()));
+    auto const written{write_image(png, info, out.get(), image, row, progress)};
+    png_destroy_write_struct(&png, &info);
+    if (!written)
+        throw std::runtime_error("Failed to write " + file);
+}
+
+/// Draw a layout scaled to fit in the middle of a square image.
+Cairo::RefPtr<Cairo::ImageSurface> draw_thumbnail(Layout const& layout, int size)
+{
+    auto image{Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, size, size)};
+    auto frame{bounding_frame(layout.figure, layout.placements)};
+    auto scale{size/std::max(frame.width, frame.height)};
+    auto cr{Cairo::Context::create(image)};
+    cr->translate(0.5*(size - frame.width*scale), 0.5*(size - frame.height*scale));
+    draw_views(cr, layout.figure, layout.placements, frame, scale);
+    return image;
+}
+
+/// Copy an image into a larger ARGB32 image's pixel data with its upper-left corner at
+/// (x, y). Copies to non-overlapping regions may be done concurrently.
+void copy_pixels(Cairo::RefPtr<Cairo::ImageSurface> const& from,
+                 unsigned char* to, int to_stride, int x, int y)
+{
+    from->flush();
+    auto data{from->get_data()};
+    auto stride{from->get_stride()};
+    for (auto row{0}; row < from->get_height(); ++row)
+        std::memcpy(to + (y + row)*to_stride + 4*x, data + row*stride, 4*from->get_width());
+}
+
+/// @return The file name with "-n" inserted before the extension.
+std::string page_name(std::string const& file, std::size_t n)
+{
+    std::filesystem::path path{file};
+    auto name{path.stem().string() + '-' + std::to_string(n) + path.extension().string()};
+    return (path.parent_path() / name).string();
+}
+
+void set_color(Cairo::RefPtr<Cairo::Context> const& cr, Color const& color,
+               double factor, double alpha)
+{
+    auto [r, g, b] = color;
+    cr->set_source_rgba(factor*r/255.0, factor*g/255.0, factor*b/255.0, alpha);
+}
+
+Frame bounding_frame(Figure const& figure, std::vector<Placement> const& views, int margin)
+{
+    if (figure.tiles().empty() || views.empty())
+        return {{-1.0*margin, -1.0*margin}, 2.0*margin, 2.0*margin};
+
+    auto box{bounds(figure, views)};
+    return {to_double(box.low - Point{margin, margin}),
+            static_cast<double>(box.width() + 2*margin),
+            static_cast<double>(box.height() + 2*margin)};
+}
+
+void draw_views(Cairo::RefPtr<Cairo::Context> const& cr,
+                Figure const& figure,
+                std::vector<Placement> const& views,
+                Frame const& frame,
+                double scale,
+                std::size_t top)
+{
+    Cairo::RefPtr<Cairo::ImageSurface> pixels;
+    draw_views(cr, figure, views, frame, scale, pixels, top);
+}
+
+void draw_views(Cairo::RefPtr<Cairo::Context> const& cr,
+                Figure const& figure,
+                std::vector<Placement> const& views,
+                Frame const& frame,
+                double scale,
+                Cairo::RefPtr<Cairo::ImageSurface>& pixels,
+                std::size_t top)
+{
+    if (scale > 1.0)
+        draw_tiles(cr, figure, views, frame, scale, top);
+    else
+        draw_pixels(cr, figure, views, frame, scale, top, pixels);
+}
+
+void write_png(std::string const& file,
+               Figure const& figure,
+               std::vector<Placement> const& views,
+               Frame const& frame,
+               double scale,
+               Progress const& progress)
+{
+    auto surface{Cairo::ImageSurface::create(
+            Cairo::FORMAT_ARGB32,
+            static_cast<int>(std::ceil(frame.width*scale)),
+            static_cast<int>(std::ceil(frame.height*scale)))};
+    draw_views(Cairo::Context::create(surface), figure, views, frame, scale);
+    if (progress)
+        progress(draw_fraction);
+    encode_png(surface, file, progress);
+}
+
+void write_svg(std::string const& file,
+               Figure const& figure,
+               std::vector<Placement> const& views,
+               Frame const& frame,
+               double scale)
+{
+    auto surface{Cairo::SvgSurface::create(file, frame.width*scale, frame.height*scale)};
+    draw_views(Cairo::Context::create(surface), figure, views, frame, scale);
+    surface->finish();
+}
+
+std::vector<std::string> write_atlas(std::string const& file,
+                                     std::vector<Layout> const& layouts,
+                                     Atlas_Options const& options)
+{
+    auto size{options.thumbnail_size};
+    auto columns{static_cast<std::size_t>(std::max(options.columns, 1))};
+    auto per_page{std::max(options.per_page, std::size_t{1})};
+    auto num_pages{(layouts.size() + per_page - 1)/per_page};
+    auto num_threads{default_threads(options.threads)};
+
+    std::vector<std::string> files;
+    for (std::size_t page{0}; page < num_pages; ++page)
+    {
+        auto first{page*per_page};
+        auto count{std::min(per_page, layouts.size() - first)};
+        auto rows{(count + columns - 1)/columns};
+        auto image{Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+                                               static_cast<int>(columns)*size,
+                                               static_cast<int>(rows)*size)};
+        image->flush();
+        auto data{image->get_data()};
+        auto stride{image->get_stride()};
+
+        // Each thread takes the next undrawn thumbnail and copies it to its place on the
+        // page. The places don't overlap so the copies don't need to be synchronized.
+        std::atomic<std::size_t> next{0};
+        auto draw = [&]() {
+            for (auto i{next++}; i < count; i = next++)
+                copy_pixels(draw_thumbnail(layouts[first + i], size), data, stride,
+                            static_cast<int>(i % columns)*size,
+                            static_cast<int>(i/columns)*size);
+        };
+        {
+            std::vector<std::jthread> threads;
+            for (auto i{0u}; i < std::min<std::size_t>(num_threads, count); ++i)
+                threads.emplace_back(draw);
+        }
+        image->mark_dirty();
+
+        files.push_back(num_pages == 1 ? file : page_name(file, page + 1));
+        image->write_to_png(files.back());
+    }
+    return files;
+}
@@ -0,0 +1,117 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_RENDER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_RENDER_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+#include "layout.hh"
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Drawing of figures with Cairo alone. Nothing here needs a display, so images can be
+// made by programs that don't open a window.
+
+/// A function that's passed the fraction of a task that's been completed.
+using Progress = std::function<void(double)>;
+
+/// A rectangle of the grid in tile units.
+struct Frame
+{
+    /// The lower-left corner.
+    Point<double> origin;
+    double width{0.0};
+    double height{0.0};
+};
+
+/// Set the color in the drawing context.
+/// @param factor Multiplies each of the RGB components.
+void set_color(Cairo::RefPtr<Cairo::Context> const& cr, Color const& color,
+               double factor = 1.0, double alpha = 1.0);
+
+/// @return The smallest frame that holds the tiles of all the views with @p margin tiles
+/// to spare on each side.
+Frame bounding_frame(Figure const& figure, std::vector<Placement> const& views,
+                     int margin = 1);
+
+/// Draw copies of a figure. View i is drawn in view_colors[i] (mod the number of colors).
+/// The lower-left corner of the frame is drawn at (0, frame.height*scale) in the
+/// context's user space. Tiles are drawn as rectangles if @p scale is greater than 1
+/// pixel, otherwise by setting one pixel per tile in an image.
+/// @param scale The width of a tile in pixels.
+/// @param top The index of the view to draw over the others, if any.
+void draw_views(Cairo::RefPtr<Cairo::Context> const& cr,
+                Figure const& figure,
+                std::vector<Placement> const& views,
+                Frame const& frame,
+                double scale,
+                std::size_t top = std::numeric_limits<std::size_t>::max());
+/// Like draw_views() above, but the image used when @p scale is 1 pixel or less is kept
+/// in @p pixels for the next call. It's only reallocated when its size changes.
+void draw_views(Cairo::RefPtr<Cairo::Context> const& cr,
+                Figure const& figure,
+                std::vector<Placement> const& views,
+                Frame const& frame,
+                double scale,
+                Cairo::RefPtr<Cairo::ImageSurface>& pixels,
+                std::size_t top = std::numeric_limits<std::size_t>::max());
+
+/// Draw the views on a transparent background and save a PNG image. The image is encoded
+/// a row at a time.
+/// @param progress If given, called after drawing and after each row is encoded.
+/// @throw std::runtime_error if the file can't be written.
+void write_png(std::string const& file,
+               Figure const& figure,
+               std::vector<Placement> const& views,
+               Frame const& frame,
+               double scale,
+               Progress const& progress = {});
+/// Draw the views and save an SVG image.
+void write_svg(std::string const& file,
+               Figure const& figure,
+               std::vector<Placement> const& views,
+               Frame const& frame,
+               double scale);
+
+/// Parameters for write_atlas().
+struct Atlas_Options
+{
+    /// The number of thumbnails in each row.
+    int columns{16};
+    /// The width and height of each thumbnail in pixels.
+    int thumbnail_size{64};
+    /// The most thumbnails on one page. Larger sets are split into several files.
+    std::size_t per_page{1024};
+    /// The number of threads drawing thumbnails. Zero means one for each core.
+    unsigned threads{0};
+};
+
+/// Draw each layout scaled to fit a thumbnail and arrange the thumbnails in rows on one
+/// or more PNG images. Thumbnails are drawn in parallel, each on its own image.
+/// @param file The name of the image. If there's more than one page, the page number is
+/// added to the name of each, e.g. "atlas-1.png", "atlas-2.png", ...
+/// @return The names of the files written.
+std::vector<std::string> write_atlas(std::string const& file,
+                                     std::vector<Layout> const& layouts,
+                                     Atlas_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_RENDER_HH_INCLUDED
@@ -0,0 +1,332 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "sat_map.hh"
+
+#include <algorithm>
+#include <array>
+#include <map>
+
+/// Add clauses that make exactly @p n of the variables true with a sequential counter.
+/// @param truth A variable that's always true.
+void add_exactly(Cnf& cnf, std::vector<int> const& vars, std::size_t n, int truth)
+{
+    // counts[j] is true if at least j + 1 of the variables so far are true.
+    std::vector<int> counts(n + 1, -truth);
+    for (auto x : vars)
+    {
+        std::vector<int> next(n + 1);
+        for (std::size_t j{0}; j <= n; ++j)
+        {
+            auto below{j > 0 ? counts[j - 1] : truth};
+            next[j] = cnf.add_variable();
+            cnf.add({-counts[j], next[j]});
+            cnf.add({-below, -x, next[j]});
+            cnf.add({-next[j], counts[j], x});
+            cnf.add({-next[j], counts[j], below});
+        }
+        counts = std::move(next);
+    }
+    if (n > 0)
+        cnf.add({counts[n - 1]});
+    cnf.add({-counts[n]});
+}
+
+/// Add clauses that make exactly one of the variables true.
+/// @return For each variable, one that's true if it or one before it is true.
+std::vector<int> add_exactly_one(Cnf& cnf, std::vector<int> const& vars)
+{
+    cnf.add(vars);
+    std::vector<int> any;
+    for (auto x : vars)
+    {
+        auto next{cnf.add_variable()};
+        cnf.add({-x, next});
+        if (!any.empty())
+        {
+            cnf.add({-any.back(), next});
+            cnf.add({-any.back(), -x});
+        }
+        any.push_back(next);
+    }
+    return any;
+}
+
+/// @return The figure's tiles moved so that the bounding box starts at (0, 0), and the
+/// size of the smallest square box that holds them.
+std::pair<Tile_List, int> normalize(Figure const& figure, Point<int>& low)
+{
+    auto box{bounds(figure.tiles())};
+    low = box.low;
+    Tile_List tiles;
+    for (auto const& t : figure.tiles())
+        tiles.insert(t - low);
+    return {tiles, std::max(box.width(), box.height())};
+}
+
+Map_Encoding encode_map(Sat_Map_Options const& options)
+{
+    Map_Encoding encoding;
+    auto& cnf{encoding.cnf};
+    auto const k{std::max<std::size_t>(options.copies, 1)};
+    auto n{options.tiles};
+    auto box{options.box > 0 ? options.box : static_cast<int>(n)};
+    Tile_List fixed;
+    if (options.figure && !options.figure->tiles().empty())
+    {
+        Point<int> low;
+        std::tie(fixed, box) = normalize(*options.figure, low);
+        n = fixed.size();
+    }
+    box = std::max(box, 1);
+
+    auto truth{cnf.add_variable()};
+    cnf.add({truth});
+    std::vector<int> shape;
+    for (auto y{0}; y < box; ++y)
+        for (auto x{0}; x < box; ++x)
+        {
+            encoding.cells.push_back({{x, y}, cnf.add_variable()});
+            shape.push_back(encoding.cells.back().second);
+        }
+    auto cell{[&](Point<int> p) {
+        return p.x >= 0 && p.x < box && p.y >= 0 && p.y < box ? shape[p.y*box + p.x] : 0;
+    }};
+
+    if (!fixed.empty())
+        for (auto const& [p, v] : encoding.cells)
+            cnf.add({fixed.contains(p) ? v : -v});
+    else
+    {
+        add_exactly(cnf, shape, n, truth);
+        // Move the figure to the low corner of the box. Ruling out the translations
+        // leaves fewer equivalent solutions to search.
+        std::vector<int> row;
+        std::vector<int> column;
+        for (auto i{0}; i < box; ++i)
+        {
+            row.push_back(cell({i, 0}));
+            column.push_back(cell({0, i}));
+        }
+        cnf.add(row);
+        cnf.add(column);
+        // Not enough for contiguity, but it rules out isolated tiles cheaply.
+        if (options.contiguous && n > 1)
+            for (auto const& [p, v] : encoding.cells)
+            {
+                std::vector<int> clause{-v};
+                for (Point<int> d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}})
+                    if (auto w{cell(p + d)})
+                        clause.push_back(w);
+                cnf.add(clause);
+            }
+        // A path between two tiles of a contiguous figure has fewer than n steps.
+        if (options.contiguous)
+            for (auto const& [p, v] : encoding.cells)
+                for (auto const& [q, w] : encoding.cells)
+                    if (p < q && std::abs(p.x - q.x) + std::abs(p.y - q.y) >= static_cast<int>(n))
+                        cnf.add({-v, -w});
+    }
+
+    // Each copy after the first touches it, so all the copies fit in a field 3 boxes on
+    // a side with the first copy's box in the middle.
+    auto const side{3*box};
+    auto index{[&](Point<int> g) {
+        return g.x >= -box && g.x < 2*box && g.y >= -box && g.y < 2*box
+            ? (g.y + box)*side + g.x + box : -1;
+    }};
+    // tiles[i][g] is true if copy i covers field position g.
+    std::vector<std::vector<int>> tiles(k, std::vector<int>(side*side, 0));
+    // chosen[i][t] is true if copy i has one of the first t + 1 placements.
+    std::vector<std::vector<int>> chosen(k);
+    for (auto y{-box}; y < 2*box; ++y)
+        for (auto x{-box}; x < 2*box; ++x)
+            tiles[0][index({x, y})] = cell({x, y});
+
+    for (std::size_t i{1}; i < k; ++i)
+    {
+        for (auto& v : tiles[i])
+            v = cnf.add_variable();
+        std::vector<std::vector<int>> covers(side*side);
+        // A placement is chosen as an orientation and the position of the copy's box.
+        // The solver learns more general clauses about these than about placements.
+        std::vector<int> turns;
+        std::vector<int> xs;
+        std::vector<int> ys;
+        for (std::size_t o{0}; o < orientations.size(); ++o)
+            turns.push_back(cnf.add_variable());
+        for (auto x{-box}; x <= box; ++x)
+        {
+            xs.push_back(cnf.add_variable());
+            ys.push_back(cnf.add_variable());
+        }
+        add_exactly_one(cnf, turns);
+        add_exactly_one(cnf, xs);
+        add_exactly_one(cnf, ys);
+
+        auto& placements{encoding.placements.emplace_back()};
+        for (std::size_t o{0}; o < orientations.size(); ++o)
+        {
+            Placement place{orientations[o], {0, 0}};
+            auto corner{place({box - 1, box - 1})};
+            Point<int> low{std::min(0, corner.x), std::min(0, corner.y)};
+            // The copy's box must reach the first box's halo.
+            for (auto y{-box}; y <= box; ++y)
+                for (auto x{-box}; x <= box; ++x)
+                {
+                    place.offset = Point<int>{x, y} - low;
+                    auto p{cnf.add_variable()};
+                    placements.push_back({place, p});
+                    auto xv{xs[x + box]};
+                    auto yv{ys[y + box]};
+                    cnf.add({-p, turns[o]});
+                    cnf.add({-p, xv});
+                    cnf.add({-p, yv});
+                    cnf.add({-turns[o], -xv, -yv, p});
+                    for (auto const& [c, v] : encoding.cells)
+                    {
+                        auto g{index(place(c))};
+                        // The tiles of a given figure are known, which saves clauses.
+                        if (!fixed.empty())
+                        {
+                            if (fixed.contains(c))
+                            {
+                                cnf.add({-p, tiles[i][g]});
+                                covers[g].push_back(p);
+                            }
+                            continue;
+                        }
+                        cnf.add({-p, -v, tiles[i][g]});
+                        cnf.add({-p, v, -tiles[i][g]});
+                        covers[g].push_back(p);
+                    }
+                }
+        }
+        for (std::size_t g{0}; g < covers.size(); ++g)
+        {
+            auto clause{covers[g]};
+            clause.push_back(-tiles[i][g]);
+            cnf.add(clause);
+        }
+        // The copies after the first are interchangeable, so put their placements in
+        // order. Copies can't share a placement, so the order is strict.
+        std::vector<int> vars;
+        for (auto const& [place, p] : placements)
+            vars.push_back(p);
+        chosen[i] = add_exactly_one(cnf, vars);
+        if (i > 1)
+            for (std::size_t t{0}; t < vars.size(); ++t)
+                cnf.add({-vars[t], t > 0 ? chosen[i - 1][t - 1] : -truth});
+    }
+
+    // No two copies overlap, and each pair shares an edge.
+    for (std::size_t i{0}; i < k; ++i)
+        for (auto j{i + 1}; j < k; ++j)
+        {
+            for (std::size_t g{0}; g < tiles[i].size(); ++g)
+                if (tiles[i][g] != 0 && tiles[j][g] != 0)
+                    cnf.add({-tiles[i][g], -tiles[j][g]});
+            // A contact is a tile of copy i next to a tile of copy j.
+            std::vector<int> contacts;
+            for (auto y{-box}; y < 2*box; ++y)
+                for (auto x{-box}; x < 2*box; ++x)
+                {
+                    auto a{tiles[i][index({x, y})]};
+                    std::vector<int> neighbors;
+                    for (Point<int> d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}})
+                        if (auto h{index(Point<int>{x, y} + d)}; h >= 0 && tiles[j][h] != 0)
+                            neighbors.push_back(tiles[j][h]);
+                    if (a == 0 || neighbors.empty())
+                        continue;
+                    auto contact{cnf.add_variable()};
+                    cnf.add({-contact, a});
+                    neighbors.push_back(-contact);
+                    cnf.add(neighbors);
+                    contacts.push_back(contact);
+                }
+            cnf.add(contacts);
+        }
+    return encoding;
+}
+
+Sat_Map_Result find_map_sat(Sat_Map_Options const& options)
+{
+    auto const start{Search_Clock::now()};
+    auto encoding{encode_map(options)};
+    Sat_Solver solver;
+    solver.add(encoding.cnf);
+    std::map<Point<int>, int> cells(encoding.cells.begin(), encoding.cells.end());
+
+    Sat_Map_Result result;
+    auto limits{options.limits};
+    while (true)
+    {
+        auto answer{solver.solve(limits)};
+        auto const& stats{solver.stats()};
+        result.stats.nodes += stats.nodes;
+        result.stats.end = stats.end;
+        if (limits.node_budget > 0)
+            limits.node_budget -= std::min(limits.node_budget - 1, stats.nodes);
+        if (answer != Sat_Result::satisfiable)
+        {
+            result.stats.fraction = answer == Sat_Result::unsatisfiable ? 1.0 : 0.0;
+            break;
+        }
+
+        Tile_List tiles;
+        for (auto const& [p, v] : encoding.cells)
+            if (solver.value(v))
+                tiles.insert(p);
+        auto parts{pieces(tiles)};
+        if (options.contiguous && parts.size() > 1)
+        {
+            // Each piece must be left out or joined to a tile next to it.
+            for (auto const& piece : parts)
+            {
+                std::vector<int> clause;
+                for (auto const& p : piece)
+                {
+                    clause.push_back(-cells[p]);
+                    for (Point<int> d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}})
+                        if (!piece.contains(p + d) && cells.contains(p + d))
+                            clause.push_back(cells[p + d]);
+                }
+                solver.add_clause(clause);
+            }
+            continue;
+        }
+
+        Layout layout{Figure{tiles}, {Placement{}}};
+        for (auto const& placements : encoding.placements)
+            for (auto const& [place, v] : placements)
+                if (solver.value(v))
+                    layout.placements.push_back(place);
+        // Put the map in the frame of the figure that was asked for.
+        if (options.figure && !options.figure->tiles().empty())
+        {
+            Point<int> low;
+            normalize(*options.figure, low);
+            layout.figure = *options.figure;
+            for (auto& place : layout.placements)
+                place = Placement{{}, low}*place*Placement{{}, -low};
+        }
+        result.layout = layout;
+        result.stats.solutions = 1;
+        result.stats.fraction = 1.0;
+        break;
+    }
+    result.stats.elapsed = Search_Clock::now() - start;
+    return result;
+}
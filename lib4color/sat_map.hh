@@ -0,0 +1,77 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SAT_MAP_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SAT_MAP_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+#include "layout.hh"
+#include "sat_solver.hh"
+#include "search_control.hh"
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+struct Sat_Map_Options
+{
+    /// The number of tiles in the figure.
+    std::size_t tiles{8};
+    /// The figure is drawn in a square of this many tiles on a side. Zero for the number
+    /// of tiles, which holds any figure.
+    int box{0};
+    /// The number of copies in a map.
+    std::size_t copies{4};
+    /// If true, the figure must be edge-connected.
+    bool contiguous{true};
+    /// If set, look only for maps of this figure. The number of tiles and the box are
+    /// taken from it.
+    std::optional<Figure> figure{};
+    /// When to end the search. A node is a conflict.
+    Search_Limits limits{};
+};
+
+/// The formula for a map problem and what its variables mean. The figure and the
+/// placements of the copies are both unknowns, so a solution is a figure together with
+/// one of its maps. The first copy is not moved.
+struct Map_Encoding
+{
+    Cnf cnf;
+    /// The variable that's true if the figure has a tile at each position in the box.
+    std::vector<std::pair<Point<int>, int>> cells;
+    /// For each copy after the first, the variable that's true for each of its
+    /// placements. Exactly one is true.
+    std::vector<std::vector<std::pair<Placement, int>>> placements;
+};
+
+/// @return The formula for maps with the given options. Contiguity is not encoded;
+/// find_map_sat() adds it as needed.
+Map_Encoding encode_map(Sat_Map_Options const& options);
+
+struct Sat_Map_Result
+{
+    /// The figure and map found, if any.
+    std::optional<Layout> layout;
+    Search_Stats stats;
+};
+
+/// Look for a figure and a map of it at the same time with the SAT solver. If the figure
+/// found is in pieces, a clause that joins one of them to the rest is added and the
+/// search goes on. A complete search without a layout shows that there's no map with
+/// the options.
+Sat_Map_Result find_map_sat(Sat_Map_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_SAT_MAP_HH_INCLUDED
@@ -0,0 +1,527 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "sat_solver.hh"
+
+#include <algorithm>
+#include <cstdlib>
+
+int Cnf::add_variable()
+{
+    return ++variables;
+}
+
+void Cnf::add(std::vector<int> clause)
+{
+    for (auto lit : clause)
+        variables = std::max(variables, std::abs(lit));
+    clauses.push_back(std::move(clause));
+}
+
+void write_dimacs(std::ostream& os, Cnf const& cnf)
+{
+    os << "p cnf " << cnf.variables << ' ' << cnf.clauses.size() << '\n';
+    for (auto const& clause : cnf.clauses)
+    {
+        for (auto lit : clause)
+            os << lit << ' ';
+        os << "0\n";
+    }
+}
+
+/// @return The i-th term, from 0, of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ...
+std::uint64_t luby(std::uint64_t i)
+{
+    std::uint64_t size{1};
+    std::uint64_t power{1};
+    while (size < i + 1)
+    {
+        size = 2*size + 1;
+        power *= 2;
+    }
+    while (size - 1 != i)
+    {
+        size = (size - 1)/2;
+        power /= 2;
+        i %= size;
+    }
+    return power;
+}
+
+Sat_Solver::Lit Sat_Solver::to_lit(int dimacs)
+{
+    return 2*(std::abs(dimacs) - 1) + (dimacs < 0 ? 1 : 0);
+}
+
+std::uint32_t Sat_Solver::var(Lit lit)
+{
+    return lit >> 1;
+}
+
+int Sat_Solver::lit_value(Lit lit) const
+{
+    auto v{m_values[var(lit)]};
+    return v < 0 ? -1 : v ^ static_cast<int>(lit & 1);
+}
+
+std::uint32_t Sat_Solver::level() const
+{
+    return m_trail_limits.size();
+}
+
+void Sat_Solver::add(Cnf const& cnf)
+{
+    grow(cnf.variables);
+    for (auto const& clause : cnf.clauses)
+        add_clause(clause);
+}
+
+int Sat_Solver::add_variable()
+{
+    grow(m_values.size() + 1);
+    return m_values.size();
+}
+
+void Sat_Solver::grow(std::uint32_t variables)
+{
+    auto old{static_cast<std::uint32_t>(m_values.size())};
+    if (variables <= old)
+        return;
+    m_watches.resize(2*variables);
+    m_values.resize(variables, -1);
+    m_levels.resize(variables, 0);
+    m_reasons.resize(variables, no_reason);
+    m_phases.resize(variables, 1);
+    m_activity.resize(variables, 0.0);
+    m_heap_index.resize(variables, -1);
+    m_seen.resize(variables, 0);
+    for (auto v{old}; v < variables; ++v)
+        heap_insert(v);
+}
+
+void Sat_Solver::add_clause(std::vector<int> const& clause)
+{
+    backtrack(0);
+    m_model.clear();
+    if (m_unsatisfiable)
+        return;
+
+    std::vector<Lit> lits;
+    for (auto d : clause)
+    {
+        grow(std::abs(d));
+        lits.push_back(to_lit(d));
+    }
+    std::sort(lits.begin(), lits.end());
+    lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+    // Drop a clause that's always satisfied, and literals that are false for good.
+    for (std::size_t i{0}; i < lits.size(); ++i)
+        if (lit_value(lits[i]) == 1 || (i > 0 && lits[i] == (lits[i - 1] ^ 1)))
+            return;
+    std::erase_if(lits, [this](Lit lit) { return lit_value(lit) == 0; });
+
+    if (lits.empty())
+        m_unsatisfiable = true;
+    else if (lits.size() == 1)
+    {
+        assign(lits.front(), no_reason);
+        m_unsatisfiable = propagate() != no_reason;
+    }
+    else
+    {
+        m_clauses.push_back({std::move(lits)});
+        attach(m_clauses.size() - 1);
+    }
+}
+
+void Sat_Solver::attach(std::int32_t clause)
+{
+    auto const& lits{m_clauses[clause].lits};
+    m_watches[lits[0]].push_back({clause, lits[1]});
+    m_watches[lits[1]].push_back({clause, lits[0]});
+}
+
+void Sat_Solver::assign(Lit lit, std::int32_t reason)
+{
+    auto v{var(lit)};
+    m_values[v] = (lit & 1) ? 0 : 1;
+    m_levels[v] = level();
+    m_reasons[v] = reason;
+    m_trail.push_back(lit);
+}
+
+std::int32_t Sat_Solver::propagate()
+{
+    while (m_propagated < m_trail.size())
+    {
+        // Visit the clauses watching the literal that just became false.
+        auto false_lit{m_trail[m_propagated++] ^ 1};
+        auto& watches{m_watches[false_lit]};
+        std::size_t i{0};
+        std::size_t j{0};
+        while (i < watches.size())
+        {
+            auto w{watches[i++]};
+            if (lit_value(w.blocker) == 1)
+            {
+                watches[j++] = w;
+                continue;
+            }
+            // Keep the false literal second so that the other watch is first.
+            auto& lits{m_clauses[w.clause].lits};
+            if (lits[0] == false_lit)
+                std::swap(lits[0], lits[1]);
+            auto first{lits[0]};
+            if (first != w.blocker && lit_value(first) == 1)
+            {
+                watches[j++] = {w.clause, first};
+                continue;
+            }
+            // Watch another literal that isn't false if there is one.
+            auto found{false};
+            for (std::size_t k{2}; k < lits.size(); ++k)
+                if (lit_value(lits[k]) != 0)
+                {
+                    std::swap(lits[1], lits[k]);
+                    m_watches[lits[1]].push_back({w.clause, first});
+                    found = true;
+                    break;
+                }
+            if (found)
+                continue;
+
+            watches[j++] = {w.clause, first};
+            if (lit_value(first) == 0)
+            {
+                while (i < watches.size())
+                    watches[j++] = watches[i++];
+                watches.resize(j);
+                m_propagated = m_trail.size();
+                return w.clause;
+            }
+            assign(first, w.clause);
+        }
+        watches.resize(j);
+    }
+    return no_reason;
+}
+
+std::pair<std::vector<Sat_Solver::Lit>, std::uint32_t>
+Sat_Solver::analyze(std::int32_t conflict)
+{
+    // Resolve the conflict with the reasons of the literals assigned at this level until
+    // one is left: the first unique implication point.
+    std::vector<Lit> learned{0};
+    std::size_t pending{0};
+    auto index{m_trail.size()};
+    auto clause{conflict};
+    auto first{true};
+    Lit p{0};
+    do
+    {
+        auto const& lits{m_clauses[clause].lits};
+        // A reason's first literal is the one it implied.
+        for (auto k{first ? 0u : 1u}; k < lits.size(); ++k)
+        {
+            auto v{var(lits[k])};
+            if (m_seen[v] || m_levels[v] == 0)
+                continue;
+            m_seen[v] = seen_implied;
+            bump(v);
+            if (m_levels[v] == level())
+                ++pending;
+            else
+                learned.push_back(lits[k]);
+        }
+        first = false;
+        while (!m_seen[var(m_trail[--index])])
+            ;
+        p = m_trail[index];
+        clause = m_reasons[var(p)];
+        m_seen[var(p)] = 0;
+        --pending;
+    } while (pending > 0);
+    learned[0] = p ^ 1;
+
+    // Drop literals implied by others in the clause.
+    std::uint32_t levels{0};
+    for (std::size_t k{1}; k < learned.size(); ++k)
+        levels |= 1u << (m_levels[var(learned[k])] % 32);
+    auto marked{learned};
+    std::erase_if(learned, [&, asserting = learned[0]](Lit lit) {
+        return lit != asserting && redundant(lit, levels, marked);
+    });
+    for (auto lit : marked)
+        m_seen[var(lit)] = 0;
+
+    // Go back to the highest level among the other literals, which is watched second.
+    std::uint32_t back{0};
+    for (std::size_t k{1}; k < learned.size(); ++k)
+        if (m_levels[var(learned[k])] > back)
+        {
+            back = m_levels[var(learned[k])];
+            std::swap(learned[1], learned[k]);
+        }
+    return {learned, back};
+}
+
+bool Sat_Solver::redundant(Lit lit, std::uint32_t levels, std::vector<Lit>& marked)
+{
+    if (m_reasons[var(lit)] == no_reason)
+        return false;
+    auto const top{marked.size()};
+    std::vector<Lit> stack{lit};
+    while (!stack.empty())
+    {
+        auto const& lits{m_clauses[m_reasons[var(stack.back())]].lits};
+        stack.pop_back();
+        for (std::size_t k{1}; k < lits.size(); ++k)
+        {
+            auto v{var(lits[k])};
+            if (m_seen[v] == seen_implied || m_levels[v] == 0)
+                continue;
+            // A decision, or a literal from a level not in the clause, can't be implied by
+            // the clause's literals.
+            if (m_seen[v] == seen_failed || m_reasons[v] == no_reason
+                || !(levels & (1u << (m_levels[v] % 32))))
+            {
+                // Remember the failure so that other literals don't repeat the work.
+                for (auto i{top}; i < marked.size(); ++i)
+                    m_seen[var(marked[i])] = seen_failed;
+                return false;
+            }
+            m_seen[v] = seen_implied;
+            stack.push_back(lits[k]);
+            marked.push_back(lits[k]);
+        }
+    }
+    return true;
+}
+
+void Sat_Solver::backtrack(std::uint32_t to)
+{
+    if (level() <= to)
+        return;
+    for (auto i{m_trail.size()}; i-- > m_trail_limits[to];)
+    {
+        auto v{var(m_trail[i])};
+        m_phases[v] = m_values[v];
+        m_values[v] = -1;
+        m_reasons[v] = no_reason;
+        heap_insert(v);
+    }
+    m_trail.resize(m_trail_limits[to]);
+    m_trail_limits.resize(to);
+    m_propagated = m_trail.size();
+}
+
+bool Sat_Solver::decide()
+{
+    while (!m_heap.empty())
+    {
+        auto v{heap_pop()};
+        if (m_values[v] >= 0)
+            continue;
+        m_trail_limits.push_back(m_trail.size());
+        assign(2*v + (m_phases[v] ? 0 : 1), no_reason);
+        return true;
+    }
+    return false;
+}
+
+void Sat_Solver::bump(std::uint32_t v)
+{
+    if ((m_activity[v] += m_bump) > 1e100)
+    {
+        for (auto& a : m_activity)
+            a *= 1e-100;
+        m_bump *= 1e-100;
+    }
+    if (m_heap_index[v] >= 0)
+        heap_up(m_heap_index[v]);
+}
+
+void Sat_Solver::reduce()
+{
+    std::vector<std::size_t> learned;
+    for (std::size_t c{0}; c < m_clauses.size(); ++c)
+        if (m_clauses[c].learned)
+            learned.push_back(c);
+    std::sort(learned.begin(), learned.end(), [this](auto a, auto b) {
+        return std::pair{m_clauses[a].lbd, m_clauses[a].lits.size()}
+            < std::pair{m_clauses[b].lbd, m_clauses[b].lits.size()};
+    });
+    for (auto i{learned.size()/2}; i < learned.size(); ++i)
+        if (m_clauses[learned[i]].lbd > 2)
+            m_clauses[learned[i]].deleted = true;
+
+    // Everything assigned at level 0 stays assigned, so drop satisfied clauses and false
+    // literals from the rest. Propagation is complete, so each clause left has at least
+    // two unassigned literals to watch.
+    std::vector<Clause> kept;
+    m_learned = 0;
+    for (auto& clause : m_clauses)
+    {
+        if (clause.deleted || std::any_of(clause.lits.begin(), clause.lits.end(),
+                                          [this](Lit lit) { return lit_value(lit) == 1; }))
+            continue;
+        std::erase_if(clause.lits, [this](Lit lit) { return lit_value(lit) == 0; });
+        m_learned += clause.learned ? 1 : 0;
+        kept.push_back(std::move(clause));
+    }
+    m_clauses = std::move(kept);
+    for (auto& watches : m_watches)
+        watches.clear();
+    for (std::size_t c{0}; c < m_clauses.size(); ++c)
+        attach(c);
+    for (auto lit : m_trail)
+        m_reasons[var(lit)] = no_reason;
+}
+
+Sat_Result Sat_Solver::solve(Search_Limits const& limits)
+{
+    Search_Control control{limits};
+    Search_Control::Counter counter;
+    auto finish{[&](Sat_Result result) {
+        control.flush(counter);
+        m_stats = control.stats(result == Sat_Result::satisfiable ? 1 : 0,
+                                result == Sat_Result::unknown ? 0.0 : 1.0);
+        return result;
+    }};
+
+    backtrack(0);
+    m_model.clear();
+    if (m_unsatisfiable || propagate() != no_reason)
+    {
+        m_unsatisfiable = true;
+        return finish(Sat_Result::unsatisfiable);
+    }
+
+    std::uint64_t restarts{0};
+    auto until_restart{100*luby(restarts)};
+    while (true)
+    {
+        if (auto conflict{propagate()}; conflict != no_reason)
+        {
+            if (level() == 0)
+            {
+                m_unsatisfiable = true;
+                return finish(Sat_Result::unsatisfiable);
+            }
+            if (!control.visit(counter))
+                return finish(Sat_Result::unknown);
+            auto [lits, back]{analyze(conflict)};
+            backtrack(back);
+            if (lits.size() == 1)
+                assign(lits.front(), no_reason);
+            else
+            {
+                std::vector<std::uint32_t> levels;
+                for (auto lit : lits)
+                    levels.push_back(m_levels[var(lit)]);
+                std::sort(levels.begin(), levels.end());
+                auto lbd{std::unique(levels.begin(), levels.end()) - levels.begin()};
+                m_clauses.push_back({std::move(lits), true, false,
+                                     static_cast<std::uint32_t>(lbd)});
+                attach(m_clauses.size() - 1);
+                assign(m_clauses.back().lits.front(), m_clauses.size() - 1);
+                ++m_learned;
+            }
+            m_bump /= 0.95;
+            if (until_restart > 0)
+                --until_restart;
+        }
+        else if (until_restart == 0)
+        {
+            backtrack(0);
+            until_restart = 100*luby(++restarts);
+            if (m_learned >= m_max_learned)
+            {
+                reduce();
+                m_max_learned += m_max_learned/10;
+            }
+        }
+        else if (!decide())
+        {
+            m_model.assign(m_values.begin(), m_values.end());
+            return finish(Sat_Result::satisfiable);
+        }
+    }
+}
+
+bool Sat_Solver::value(int variable) const
+{
+    return variable > 0 && static_cast<std::size_t>(variable) <= m_model.size()
+        && m_model[variable - 1];
+}
+
+Search_Stats const& Sat_Solver::stats() const
+{
+    return m_stats;
+}
+
+void Sat_Solver::heap_insert(std::uint32_t v)
+{
+    if (m_heap_index[v] >= 0)
+        return;
+    m_heap_index[v] = m_heap.size();
+    m_heap.push_back(v);
+    heap_up(m_heap.size() - 1);
+}
+
+void Sat_Solver::heap_up(std::size_t i)
+{
+    auto v{m_heap[i]};
+    while (i > 0 && m_activity[m_heap[(i - 1)/2]] < m_activity[v])
+    {
+        m_heap[i] = m_heap[(i - 1)/2];
+        m_heap_index[m_heap[i]] = i;
+        i = (i - 1)/2;
+    }
+    m_heap[i] = v;
+    m_heap_index[v] = i;
+}
+
+void Sat_Solver::heap_down(std::size_t i)
+{
+    auto v{m_heap[i]};
+    while (2*i + 1 < m_heap.size())
+    {
+        auto child{2*i + 1};
+        if (child + 1 < m_heap.size() && m_activity[m_heap[child + 1]] > m_activity[m_heap[child]])
+            ++child;
+        if (m_activity[m_heap[child]] <= m_activity[v])
+            break;
+        m_heap[i] = m_heap[child];
+        m_heap_index[m_heap[i]] = i;
+        i = child;
+    }
+    m_heap[i] = v;
+    m_heap_index[v] = i;
+}
+
+std::uint32_t Sat_Solver::heap_pop()
+{
+    auto v{m_heap.front()};
+    m_heap_index[v] = -1;
+    m_heap.front() = m_heap.back();
+    m_heap.pop_back();
+    if (!m_heap.empty())
+    {
+        m_heap_index[m_heap.front()] = 0;
+        heap_down(0);
+    }
+    return v;
+}
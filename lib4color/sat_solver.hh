@@ -0,0 +1,147 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SAT_SOLVER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SAT_SOLVER_HH_INCLUDED
+
+#include "search_control.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/// A formula in conjunctive normal form. Variables are numbered from 1, and the literal
+/// -v is the negation of v, as in DIMACS files.
+struct Cnf
+{
+    int variables{0};
+    std::vector<std::vector<int>> clauses;
+
+    /// @return A new variable.
+    int add_variable();
+    void add(std::vector<int> clause);
+};
+
+/// Write a formula in the DIMACS format read by most SAT solvers.
+void write_dimacs(std::ostream& os, Cnf const& cnf);
+
+enum class Sat_Result
+{
+    satisfiable,
+    unsatisfiable,
+    /// The search was ended by its limits.
+    unknown,
+};
+
+/// A conflict-driven clause-learning SAT solver: two watched literals, first-UIP
+/// learning, VSIDS decisions with phase saving, Luby restarts, and deletion of learned
+/// clauses with high literal block distance. Clauses can be added between calls to
+/// solve().
+class Sat_Solver
+{
+public:
+    /// Add the variables and clauses of a formula.
+    void add(Cnf const& cnf);
+    /// @return A new variable.
+    int add_variable();
+    /// Add a clause of DIMACS literals. Variables are created as needed.
+    void add_clause(std::vector<int> const& clause);
+
+    /// Look for an assignment that satisfies all the clauses. A node is a conflict.
+    Sat_Result solve(Search_Limits const& limits = {});
+    /// @return The value of a variable in the assignment found by the last solve().
+    bool value(int variable) const;
+    /// @return The statistics of the last solve().
+    Search_Stats const& stats() const;
+
+private:
+    using Lit = std::uint32_t;
+    static constexpr std::int32_t no_reason{-1};
+    /// Marks for variables during conflict analysis.
+    static constexpr std::uint8_t seen_implied{1};
+    static constexpr std::uint8_t seen_failed{2};
+
+    struct Clause
+    {
+        std::vector<Lit> lits;
+        bool learned{false};
+        bool deleted{false};
+        /// The number of decision levels among the literals when the clause was learned.
+        std::uint32_t lbd{0};
+    };
+    struct Watch
+    {
+        std::int32_t clause;
+        /// A literal of the clause. If it's true, the clause needn't be visited.
+        Lit blocker;
+    };
+
+    static Lit to_lit(int dimacs);
+    static std::uint32_t var(Lit lit);
+    /// @return 1 if the literal is true, 0 if false, -1 if unassigned.
+    int lit_value(Lit lit) const;
+    std::uint32_t level() const;
+    void grow(std::uint32_t variables);
+    void attach(std::int32_t clause);
+    void assign(Lit lit, std::int32_t reason);
+    /// @return The conflicting clause, or no_reason.
+    std::int32_t propagate();
+    /// Learn a clause from a conflict.
+    /// @return The learned literals, the asserting one first, and the level to go back to.
+    std::pair<std::vector<Lit>, std::uint32_t> analyze(std::int32_t conflict);
+    /// @return True if the literal of a learned clause is implied by the others. Literals
+    /// found to be implied or not are marked and added to @p marked.
+    /// @param levels A bit for each decision level in the clause, modulo 32.
+    bool redundant(Lit lit, std::uint32_t levels, std::vector<Lit>& marked);
+    void backtrack(std::uint32_t level);
+    /// Assign the unassigned variable with the highest activity its saved phase.
+    /// @return False if all variables are assigned.
+    bool decide();
+    void bump(std::uint32_t v);
+    /// Delete half of the learned clauses, keeping the ones with the lowest LBD. Must be
+    /// called at level 0.
+    void reduce();
+
+    /// Variable order for decisions: a binary max-heap on activity.
+    void heap_insert(std::uint32_t v);
+    void heap_up(std::size_t i);
+    void heap_down(std::size_t i);
+    std::uint32_t heap_pop();
+
+    std::vector<Clause> m_clauses;
+    std::vector<std::vector<Watch>> m_watches;
+    std::vector<std::int8_t> m_values;
+    std::vector<std::uint32_t> m_levels;
+    std::vector<std::int32_t> m_reasons;
+    std::vector<std::int8_t> m_phases;
+    std::vector<double> m_activity;
+    double m_bump{1.0};
+    std::vector<std::uint32_t> m_heap;
+    /// The position of each variable in the heap, or -1.
+    std::vector<std::int64_t> m_heap_index;
+    std::vector<Lit> m_trail;
+    /// The start of each decision level in the trail.
+    std::vector<std::size_t> m_trail_limits;
+    std::size_t m_propagated{0};
+    std::vector<std::uint8_t> m_seen;
+    std::size_t m_learned{0};
+    std::size_t m_max_learned{2000};
+    /// True once the clauses are known to be unsatisfiable.
+    bool m_unsatisfiable{false};
+    std::vector<bool> m_model;
+    Search_Stats m_stats;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SAT_SOLVER_HH_INCLUDED
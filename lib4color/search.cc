@@ -0,0 +1,382 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "search.hh"
+#include "bitboard.hh"
+#include "holes.hh"
+#include "layout.hh"
+#include "region_graph.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <tuple>
+
+using Bits = std::vector<std::uint64_t>;
+
+/// A placement of a copy that touches the unmoved copy without overlapping it.
+struct Candidate
+{
+    Placement place;
+    Bitboard tiles;
+    Bitboard halo;
+};
+
+/// @return All the distinct candidates for the figure's copies. Tiles are placed on a
+/// board big enough to hold any copy that touches the unmoved one. Empty if the search
+/// is stopped. The limits are checked for each row of offsets tried.
+std::vector<Candidate> find_candidates(Figure const& figure, Search_Control& control)
+{
+    std::vector<Candidate> candidates;
+    if (figure.tiles().empty())
+        return candidates;
+
+    auto box{bounds(figure.tiles())};
+    auto margin{std::max(box.width(), box.height())};
+    auto origin{box.low - Point<int>{margin, margin}};
+    auto size{box.high - box.low + Point<int>{2*margin + 1, 2*margin + 1}};
+
+    auto board{[&](Placement const& place) {
+        Bitboard b(size.x, size.y);
+        for (auto const& p : figure.tiles())
+            b.set(place(p) - origin);
+        return b;
+    }};
+    auto base{board({})};
+    auto base_halo{base.halo()};
+
+    // Symmetric figures give the same tiles for more than one placement. Keep the first.
+    std::set<std::vector<Point<int>>> seen;
+    std::vector<Point<int>> oriented(figure.tiles().size());
+    for (auto const& m : orientations)
+    {
+        Placement place{m, {0, 0}};
+        std::transform(figure.tiles().begin(), figure.tiles().end(), oriented.begin(), place);
+        auto turned{bounds(figure, place)};
+        for (auto y{origin.y - turned.low.y}; y + turned.high.y < origin.y + size.y; ++y)
+        {
+            if (!control.check())
+                return {};
+            for (auto x{origin.x - turned.low.x}; x + turned.high.x < origin.x + size.x; ++x)
+            {
+                place.offset = {x, y};
+                auto tiles{board(place)};
+                if (tiles.intersects(base) || !tiles.intersects(base_halo))
+                    continue;
+                std::vector<Point<int>> key(oriented.size());
+                std::transform(figure.tiles().begin(), figure.tiles().end(), key.begin(),
+                               place);
+                std::sort(key.begin(), key.end());
+                if (!seen.insert(std::move(key)).second)
+                    continue;
+                auto halo{tiles.halo()};
+                candidates.push_back({place, std::move(tiles), std::move(halo)});
+            }
+        }
+    }
+    return candidates;
+}
+
+/// @return Bit j of element i is set if candidates i and j, i < j, can both be in a
+/// map. Empty if the search is stopped. The limits are checked for each row.
+std::vector<Bits> compatibility(std::vector<Candidate> const& candidates,
+                                Search_Control& control)
+{
+    auto n{candidates.size()};
+    std::vector<Bits> compatible(n, Bits((n + 63)/64, 0));
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        if (!control.check())
+            return {};
+        for (auto j{i + 1}; j < n; ++j)
+            if (!candidates[i].tiles.intersects(candidates[j].tiles)
+                && candidates[i].halo.intersects(candidates[j].tiles))
+                compatible[i][j/64] |= std::uint64_t{1} << (j % 64);
+    }
+    return compatible;
+}
+
+/// A sortable stand-in for a copy's tiles.
+using Copy_Key = std::tuple<std::size_t, int, int>;
+
+/// @return The key for the copy placed by @p place. Placements that differ by a symmetry
+/// of the figure give the same tiles, so they get the same key.
+Copy_Key copy_key(Placement const& place, std::vector<Placement> const& syms)
+{
+    Copy_Key key{orientations.size(), 0, 0};
+    for (auto const& s : syms)
+    {
+        auto p{place*s};
+        key = std::min(key, Copy_Key{orientation_index(p.transform), p.offset.x, p.offset.y});
+    }
+    return key;
+}
+
+/// @return The sorted keys of the copies after moving copy @p anchor to the origin and
+/// applying symmetry @p sym.
+std::vector<Copy_Key> map_key(Solution const& solution,
+                              std::size_t anchor,
+                              Placement const& sym,
+                              std::vector<Placement> const& syms)
+{
+    auto move{sym*inverse(solution[anchor])};
+    std::vector<Copy_Key> keys;
+    for (auto const& place : solution)
+        keys.push_back(copy_key(move*place, syms));
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+/// @return True if no other choice of the unmoved copy gives a smaller key.
+bool is_representative(Solution const& solution, std::vector<Placement> const& syms)
+{
+    auto key{map_key(solution, 0, {}, syms)};
+    for (std::size_t anchor{0}; anchor < solution.size(); ++anchor)
+        for (auto const& s : syms)
+            if (map_key(solution, anchor, s, syms) < key)
+                return false;
+    return true;
+}
+
+/// @return True if a map passes the options' filters.
+bool is_wanted(Figure const& figure, Solution const& solution, Search_Options const& options)
+{
+    return (!options.hole_free || find_holes(figure, solution).empty())
+        && (options.min_colors == 0
+            || chromatic_number(region_graph(figure, solution)) >= options.min_colors);
+}
+
+std::size_t map_area(Figure const& figure, Solution const& solution)
+{
+    if (figure.tiles().empty() || solution.empty())
+        return 0;
+    return bounds(figure, solution).area();
+}
+
+unsigned search_threads(Search_Options const& options)
+{
+    return default_threads(options.threads);
+}
+
+Search_Stats find_maps(Figure const& figure,
+                       Solution_Handler const& handler,
+                       Search_Options const& options)
+{
+    Search_Control control{options.limits};
+    if (options.copies < 2)
+        return control.stats(0, 1.0);
+    auto candidates{find_candidates(figure, control)};
+    auto n{candidates.size()};
+    auto words{(n + 63)/64};
+
+    auto compatible{compatibility(candidates, control)};
+    if (!control.check())
+        return control.stats(0, 0.0);
+
+    auto syms{symmetries(figure)};
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> found{0};
+    std::atomic<std::size_t> done{0};
+
+    auto work{[&](unsigned thread) {
+        Search_Control::Counter counter;
+        Solution solution(options.copies);
+        std::vector<std::size_t> chosen(options.copies - 1);
+        // Extend the map with candidates compatible with all those chosen so far.
+        std::function<void(std::size_t, Bits const&)> extend{
+            [&](std::size_t depth, Bits const& allowed) {
+                if (depth == chosen.size())
+                {
+                    for (std::size_t c{0}; c < chosen.size(); ++c)
+                        solution[c + 1] = candidates[chosen[c]].place;
+                    if ((!options.unique || is_representative(solution, syms))
+                        && is_wanted(figure, solution, options))
+                    {
+                        ++found;
+                        handler(thread, solution);
+                    }
+                    return;
+                }
+                Bits next_allowed(words);
+                for (std::size_t w{0}; w < words; ++w)
+                    for (auto bits{allowed[w]}; bits != 0; bits &= bits - 1)
+                    {
+                        if (!control.visit(counter))
+                            return;
+                        auto j{w*64 + std::countr_zero(bits)};
+                        chosen[depth] = j;
+                        for (auto v{0u}; v < words; ++v)
+                            next_allowed[v] = allowed[v] & compatible[j][v];
+                        extend(depth + 1, next_allowed);
+                    }
+            }};
+        try
+        {
+            for (auto i{next++}; i < n && !control.stopped(); i = next++)
+            {
+                chosen[0] = i;
+                extend(1, compatible[i]);
+                // A stopped subtree isn't done.
+                if (control.stopped())
+                    break;
+                auto fraction{static_cast<double>(++done)/n};
+                if (options.progress)
+                    options.progress(fraction);
+            }
+        }
+        catch (...)
+        {
+            // An exception would end the program if it left the thread.
+            control.fail(std::current_exception());
+        }
+        control.flush(counter);
+    }};
+
+    {
+        std::vector<std::jthread> workers;
+        for (auto t{0u}; t < search_threads(options); ++t)
+            workers.emplace_back(work, t);
+    }
+    control.rethrow();
+    return control.stats(found, n > 0 ? static_cast<double>(done)/n : 1.0);
+}
+
+Search_Result collect_maps(Figure const& figure, Search_Options const& options)
+{
+    Search_Result result;
+    std::mutex mutex;
+    result.stats = find_maps(figure, [&](unsigned, Solution const& solution) {
+        std::lock_guard lock{mutex};
+        result.solutions.push_back(solution);
+    }, options);
+    return result;
+}
+
+Compact_Result find_compact_map(Figure const& figure, Search_Options const& options)
+{
+    Search_Control control{options.limits};
+    Compact_Result result;
+    if (options.copies < 2 || figure.tiles().empty())
+    {
+        result.stats = control.stats(0, 1.0);
+        return result;
+    }
+    // Try the candidates that add the least to the unmoved copy's box first so that a
+    // small map is found early and prunes the rest.
+    auto candidates{find_candidates(figure, control)};
+    auto base{bounds(figure, Placement{})};
+    std::vector<Bounds> boxes;
+    for (auto const& c : candidates)
+        boxes.push_back(bounds(figure, c.place));
+    std::vector<std::size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto i, auto j) {
+        return (base | boxes[i]).area() < (base | boxes[j]).area();
+    });
+    {
+        std::vector<Candidate> sorted;
+        std::vector<Bounds> sorted_boxes;
+        for (auto i : order)
+        {
+            sorted.push_back(std::move(candidates[i]));
+            sorted_boxes.push_back(boxes[i]);
+        }
+        candidates = std::move(sorted);
+        boxes = std::move(sorted_boxes);
+    }
+    auto n{candidates.size()};
+    auto words{(n + 63)/64};
+    auto compatible{compatibility(candidates, control)};
+    if (!control.check())
+    {
+        result.stats = control.stats(0, 0.0);
+        return result;
+    }
+
+    // The smallest area found so far. It's read without the lock to prune.
+    std::atomic<std::size_t> best_area{std::numeric_limits<std::size_t>::max()};
+    std::mutex mutex;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> done{0};
+
+    auto work{[&](unsigned) {
+        Search_Control::Counter counter;
+        std::vector<std::size_t> chosen(options.copies - 1);
+        // Adding copies only grows the box, so its area is a lower bound for every map
+        // in the branch.
+        std::function<void(std::size_t, Bits const&, Bounds const&)> extend{
+            [&](std::size_t depth, Bits const& allowed, Bounds const& box) {
+                if (depth == chosen.size())
+                {
+                    Solution solution{Placement{}};
+                    for (auto c : chosen)
+                        solution.push_back(candidates[c].place);
+                    if (!is_wanted(figure, solution, options))
+                        return;
+                    std::lock_guard lock{mutex};
+                    if (box.area() < best_area)
+                    {
+                        result.solution = solution;
+                        best_area = box.area();
+                    }
+                    return;
+                }
+                Bits next_allowed(words);
+                for (std::size_t w{0}; w < words; ++w)
+                    for (auto bits{allowed[w]}; bits != 0; bits &= bits - 1)
+                    {
+                        if (!control.visit(counter))
+                            return;
+                        auto j{w*64 + std::countr_zero(bits)};
+                        auto grown{box | boxes[j]};
+                        if (grown.area() >= best_area)
+                            continue;
+                        chosen[depth] = j;
+                        for (auto v{0u}; v < words; ++v)
+                            next_allowed[v] = allowed[v] & compatible[j][v];
+                        extend(depth + 1, next_allowed, grown);
+                    }
+            }};
+        for (auto i{next++}; i < n && !control.stopped(); i = next++)
+        {
+            if ((base | boxes[i]).area() < best_area)
+            {
+                chosen[0] = i;
+                extend(1, compatible[i], base | boxes[i]);
+            }
+            if (control.stopped())
+                break;
+            auto fraction{static_cast<double>(++done)/n};
+            if (options.progress)
+                options.progress(fraction);
+        }
+        control.flush(counter);
+    }};
+
+    {
+        std::vector<std::jthread> workers;
+        for (auto t{0u}; t < search_threads(options); ++t)
+            workers.emplace_back(work, t);
+    }
+    result.area = result.solution ? best_area.load() : 0;
+    result.stats = control.stats(result.solution ? 1 : 0,
+                                 n > 0 ? static_cast<double>(done)/n : 1.0);
+    return result;
+}
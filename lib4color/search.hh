@@ -0,0 +1,99 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SEARCH_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SEARCH_HH_INCLUDED
+
+#include "figure.hh"
+#include "figure_view.hh"
+#include "search_control.hh"
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+/// The placements of the copies of a figure that make a map. The first copy is not
+/// moved.
+using Solution = std::vector<Placement>;
+
+/// Called for each solution found. Calls from different threads may overlap, but each
+/// thread passes its own index, so per-thread state needs no locking. If a handler
+/// throws, the search stops, and the first exception is rethrown once all the threads
+/// have finished.
+using Solution_Handler = std::function<void(unsigned thread, Solution const& solution)>;
+
+struct Search_Options
+{
+    /// The number of copies in a map. Each copy must share an edge with all the others.
+    std::size_t copies{4};
+    /// The number of worker threads. Zero for one per core.
+    unsigned threads{0};
+    /// If true, report a map once instead of once for each copy and symmetry of the
+    /// figure that could be the unmoved one.
+    bool unique{true};
+    /// When to end the search early. A node is a placement tried.
+    Search_Limits limits{};
+    /// Called with the fraction of the search done. Calls come from the worker threads
+    /// and may overlap.
+    std::function<void(double)> progress{};
+    /// If true, report only maps that leave no empty region enclosed by the copies.
+    bool hole_free{false};
+    /// If not zero, report only maps that need at least this many colors, counting the
+    /// holes and the outside as regions.
+    std::size_t min_colors{0};
+};
+
+/// @return The area of the smallest rectangle that holds all the copies. Smaller maps
+/// are easier to take in.
+std::size_t map_area(Figure const& figure, Solution const& solution);
+
+/// @return The number of threads that find_maps() will use.
+unsigned search_threads(Search_Options const& options);
+
+/// Find all the ways to place copies of a figure so that no two overlap and each shares
+/// an edge with all the others.
+/// @return The statistics of the search, including the number of solutions reported.
+Search_Stats find_maps(Figure const& figure,
+                       Solution_Handler const& handler,
+                       Search_Options const& options = {});
+
+/// The solutions found by a search and how it went.
+struct Search_Result
+{
+    std::vector<Solution> solutions;
+    Search_Stats stats;
+};
+
+/// Like find_maps(), but collect the solutions instead of handling them as they're found.
+/// Useful for searches with a small budget.
+Search_Result collect_maps(Figure const& figure, Search_Options const& options = {});
+
+/// The most compact map found by a search.
+struct Compact_Result
+{
+    /// A map with the smallest area, if there is a map.
+    std::optional<Solution> solution;
+    /// The map's area as given by map_area().
+    std::size_t area{0};
+    Search_Stats stats;
+};
+
+/// Find a map with the smallest area by branch and bound. The box around the copies
+/// placed so far only grows as copies are added, so a branch is dropped as soon as its
+/// box is no smaller than the best map's. The best area is shared by the threads. The
+/// unique option is ignored; the smallest map is the same for all of its copies.
+Compact_Result find_compact_map(Figure const& figure, Search_Options const& options = {});
+
+#endif // FOUR_COLOR_LIB4COLOR_SEARCH_HH_INCLUDED
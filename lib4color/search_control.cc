@@ -0,0 +1,96 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "search_control.hh"
+
+#include <algorithm>
+#include <thread>
+
+unsigned default_threads(unsigned requested)
+{
+    return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+Search_Limits Search_Limits::within(Search_Clock::duration time, std::stop_token stop)
+{
+    return {stop, Search_Clock::now() + time, 0};
+}
+
+Search_Control::Search_Control(Search_Limits const& limits)
+    : m_limits{limits},
+      m_start{Search_Clock::now()}
+{
+}
+
+bool Search_Control::check(Counter& counter)
+{
+    flush(counter);
+    counter.stopped = !check();
+    return !counter.stopped;
+}
+
+void Search_Control::flush(Counter& counter)
+{
+    m_nodes += counter.unreported;
+    counter.unreported = 0;
+}
+
+bool Search_Control::check()
+{
+    if (stopped())
+        return false;
+    if (m_limits.stop.stop_requested())
+        end(Search_End::stopped);
+    else if (m_limits.node_budget > 0 && m_nodes >= m_limits.node_budget)
+        end(Search_End::budget);
+    else if (m_limits.deadline != Search_Clock::time_point::max()
+             && Search_Clock::now() >= m_limits.deadline)
+        end(Search_End::deadline);
+    return !stopped();
+}
+
+bool Search_Control::stopped() const
+{
+    return m_end.load(std::memory_order_relaxed) != Search_End::complete;
+}
+
+void Search_Control::fail(std::exception_ptr error)
+{
+    {
+        std::lock_guard lock{m_error_mutex};
+        if (!m_error)
+            m_error = error;
+    }
+    end(Search_End::stopped);
+}
+
+void Search_Control::rethrow() const
+{
+    std::lock_guard lock{m_error_mutex};
+    if (m_error)
+        std::rethrow_exception(m_error);
+}
+
+void Search_Control::end(Search_End reason)
+{
+    // The first reason found is kept.
+    auto expected{Search_End::complete};
+    m_end.compare_exchange_strong(expected, reason);
+}
+
+Search_Stats Search_Control::stats(std::size_t solutions, double fraction) const
+{
+    return {m_end, m_nodes, solutions, fraction, Search_Clock::now() - m_start};
+}
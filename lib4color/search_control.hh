@@ -0,0 +1,130 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SEARCH_CONTROL_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SEARCH_CONTROL_HH_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stop_token>
+
+using Search_Clock = std::chrono::steady_clock;
+
+/// Bounds on a search. The default is no bounds.
+struct Search_Limits
+{
+    /// The search ends when a stop is requested.
+    std::stop_token stop{};
+    /// The search ends after this time.
+    Search_Clock::time_point deadline{Search_Clock::time_point::max()};
+    /// The search ends after visiting this many nodes. Zero for no limit.
+    std::uint64_t node_budget{0};
+
+    /// @return Limits that end a search after a time from now.
+    static Search_Limits within(Search_Clock::duration time, std::stop_token stop = {});
+};
+
+/// @return The number of worker threads to use when @p requested are asked for. Zero asks
+/// for one per core.
+unsigned default_threads(unsigned requested);
+
+/// Why a search ended.
+enum class Search_End
+{
+    complete,
+    stopped,
+    deadline,
+    budget,
+};
+
+/// What happened in a search. If it ended early, the solutions reported so far are still
+/// good.
+struct Search_Stats
+{
+    Search_End end{Search_End::complete};
+    /// The number of nodes visited. The meaning of a node depends on the search.
+    std::uint64_t nodes{0};
+    /// The number of solutions reported.
+    std::size_t solutions{0};
+    /// The fraction of the search space covered.
+    double fraction{0.0};
+    Search_Clock::duration elapsed{};
+
+    bool complete() const
+    {
+        return end == Search_End::complete;
+    }
+};
+
+/// Enforces search limits cheaply from any number of threads. Each thread counts nodes
+/// in its own counter, and the shared state is checked only every check_interval nodes,
+/// so limits may be overshot by that many nodes per thread.
+class Search_Control
+{
+public:
+    static constexpr std::uint64_t check_interval{256};
+
+    /// A node counter for one thread.
+    struct Counter
+    {
+        std::uint64_t unreported{0};
+        /// Set when this thread sees that the search has ended, so that it keeps
+        /// returning false while unwinding.
+        bool stopped{false};
+    };
+
+    explicit Search_Control(Search_Limits const& limits);
+
+    /// Count a node.
+    /// @return True if the search should go on.
+    bool visit(Counter& counter)
+    {
+        return !counter.stopped
+            && (++counter.unreported < check_interval || check(counter));
+    }
+    /// Add the thread's nodes to the total and check the limits.
+    /// @return True if the search should go on.
+    bool check(Counter& counter);
+    /// Add the thread's nodes to the total without checking the limits. Called when a
+    /// thread is done.
+    void flush(Counter& counter);
+    /// Check the limits between nodes, e.g. between phases of a search.
+    /// @return True if the search should go on.
+    bool check();
+    /// @return True if a limit has been reached.
+    bool stopped() const;
+    /// End the search because a worker thread threw. The first error is kept.
+    void fail(std::exception_ptr error);
+    /// Throw the error passed to fail(), if any. Called after the workers have finished.
+    void rethrow() const;
+    /// @return The statistics so far.
+    Search_Stats stats(std::size_t solutions, double fraction) const;
+
+private:
+    /// End the search for a reason unless it has already ended.
+    void end(Search_End reason);
+
+    Search_Limits m_limits;
+    Search_Clock::time_point m_start;
+    std::atomic<std::uint64_t> m_nodes{0};
+    std::atomic<Search_End> m_end{Search_End::complete};
+    mutable std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SEARCH_CONTROL_HH_INCLUDED
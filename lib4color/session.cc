@@ -0,0 +1,199 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "session.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// The records are read in place, so their layout must not change.
+static_assert(sizeof(Session_Header) == 48);
+static_assert(sizeof(State_Record) == 24);
+static_assert(sizeof(Placement) == 24 && std::is_trivially_copyable_v<Placement>);
+static_assert(sizeof(Point<int>) == 8 && std::is_trivially_copyable_v<Point<int>>);
+
+constexpr char session_magic[8]{'4', 'c', 'o', 'l', 'o', 'r', 'S', '\n'};
+constexpr std::uint32_t session_version{1};
+
+/// Write the bytes of an array of records.
+template <typename T> void write_records(std::ostream& os, T const* records, std::size_t n)
+{
+    os.write(reinterpret_cast<char const*>(records), n*sizeof(T));
+}
+
+void write_session(std::string const& file,
+                   std::vector<Session_State> const& states,
+                   std::size_t now)
+{
+    assert(now < states.size());
+    auto num_views{states.front().layout.placements.size()};
+
+    Session_Header header{};
+    std::memcpy(header.magic, session_magic, sizeof(session_magic));
+    header.version = session_version;
+    header.num_states = states.size();
+    header.now = now;
+    header.num_views = num_views;
+
+    std::vector<State_Record> records;
+    for (auto const& state : states)
+    {
+        assert(state.layout.placements.size() == num_views);
+        auto n{state.layout.figure.tiles().size()};
+        records.push_back({header.num_tiles, n, state.focus});
+        header.num_tiles += n;
+    }
+
+    auto const temp_file{file + ".tmp"};
+    std::ofstream os{temp_file, std::ios::binary | std::ios::trunc};
+    if (!os)
+        throw std::runtime_error("Can't open " + temp_file + " for writing");
+    write_records(os, &header, 1);
+    write_records(os, records.data(), records.size());
+    for (auto const& state : states)
+        write_records(os, state.layout.placements.data(), num_views);
+    for (auto const& state : states)
+    {
+        // Tile_List is ordered, so the tiles go out sorted.
+        std::vector<Point<int>> tiles{state.layout.figure.tiles().begin(),
+                                      state.layout.figure.tiles().end()};
+        write_records(os, tiles.data(), tiles.size());
+    }
+    if (!os.flush())
+        throw std::runtime_error("Failed to write " + temp_file);
+    os.close();
+    std::error_code error;
+    std::filesystem::rename(temp_file, file, error);
+    if (error)
+        throw std::runtime_error("Can't replace " + file + ": " + error.message());
+}
+
+Session_File::Session_File(std::string const& file)
+{
+    auto fd{::open(file.c_str(), O_RDONLY)};
+    if (fd < 0)
+        throw std::runtime_error("Can't open " + file);
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(Session_Header)))
+    {
+        m_size = info.st_size;
+        m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (m_data == nullptr || m_data == MAP_FAILED)
+    {
+        m_data = nullptr;
+        throw std::runtime_error(file + " is not a session file");
+    }
+
+    auto bytes{static_cast<char const*>(m_data)};
+    m_header = reinterpret_cast<Session_Header const*>(bytes);
+    auto const& h{*m_header};
+    // The counts come from the file, so a crafted header could make the size wrap around
+    // to match. Any overflow makes the file invalid.
+    std::uint64_t num_placements{0};
+    std::uint64_t expected_size{0};
+    auto overflow{__builtin_mul_overflow(h.num_states, h.num_views, &num_placements)};
+    using Records = std::pair<std::uint64_t, std::size_t>;
+    for (auto [count, size] : {Records{1, sizeof(Session_Header)},
+                               Records{h.num_states, sizeof(State_Record)},
+                               Records{num_placements, sizeof(Placement)},
+                               Records{h.num_tiles, sizeof(Point<int>)}})
+    {
+        std::uint64_t bytes{0};
+        overflow = overflow || __builtin_mul_overflow(count, size, &bytes)
+            || __builtin_add_overflow(expected_size, bytes, &expected_size);
+    }
+    auto valid{std::memcmp(h.magic, session_magic, sizeof(session_magic)) == 0
+               && h.version == session_version
+               && h.now < h.num_states
+               && !overflow
+               && m_size == expected_size};
+    if (valid)
+    {
+        m_states = reinterpret_cast<State_Record const*>(bytes + sizeof(Session_Header));
+        m_placements = reinterpret_cast<Placement const*>(m_states + h.num_states);
+        m_tiles = reinterpret_cast<Point<int> const*>(m_placements
+                                                      + h.num_states*h.num_views);
+        // Check the records so that the accessors can't read outside the file.
+        for (std::size_t i{0}; valid && i < h.num_states; ++i)
+            valid = m_states[i].first_tile <= h.num_tiles
+                && m_states[i].num_tiles <= h.num_tiles - m_states[i].first_tile
+                && m_states[i].focus < h.num_views;
+    }
+    if (!valid)
+    {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        throw std::runtime_error(file + " is not a valid session file");
+    }
+}
+
+Session_File::~Session_File()
+{
+    if (m_data)
+        ::munmap(m_data, m_size);
+}
+
+std::size_t Session_File::num_states() const
+{
+    return m_header->num_states;
+}
+
+std::size_t Session_File::now() const
+{
+    return m_header->now;
+}
+
+std::size_t Session_File::num_views() const
+{
+    return m_header->num_views;
+}
+
+std::span<Point<int> const> Session_File::tiles(std::size_t state) const
+{
+    assert(state < num_states());
+    return {m_tiles + m_states[state].first_tile, m_states[state].num_tiles};
+}
+
+std::span<Placement const> Session_File::placements(std::size_t state) const
+{
+    assert(state < num_states());
+    return {m_placements + state*num_views(), num_views()};
+}
+
+std::size_t Session_File::focus(std::size_t state) const
+{
+    assert(state < num_states());
+    return m_states[state].focus;
+}
+
+Session_State Session_File::state(std::size_t state) const
+{
+    auto ts{tiles(state)};
+    auto ps{placements(state)};
+    return {{Figure{Tile_List{ts.begin(), ts.end()}}, {ps.begin(), ps.end()}}, focus(state)};
+}
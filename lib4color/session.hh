@@ -0,0 +1,110 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SESSION_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SESSION_HH_INCLUDED
+
+#include "layout.hh"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// A session file holds a sequence of states: the figure, the placements of its views,
+// and the focused view. All states have the same number of views. Everything is stored
+// as fixed-width native-endian records so a mapped file can be read in place.
+//
+//   Session_Header
+//   State_Record[num_states]
+//   Placement[num_states*num_views]
+//   Point<int>[num_tiles]  The tiles of all states' figures.
+
+/// The start of a session file.
+struct Session_Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t num_states;
+    /// The index of the current state.
+    std::uint64_t now;
+    std::uint64_t num_views;
+    std::uint64_t num_tiles;
+};
+
+/// The description of one state in a session file.
+struct State_Record
+{
+    /// The index of the figure's first tile in the tile array.
+    std::uint64_t first_tile;
+    std::uint64_t num_tiles;
+    /// The index of the focused view.
+    std::uint64_t focus;
+};
+
+/// One state of a session.
+struct Session_State
+{
+    Layout layout;
+    std::size_t focus{0};
+};
+
+/// Write the states to a session file. The file is written under a temporary name and
+/// then renamed, so a Session_File that maps the old file keeps reading the old states.
+/// @param now The index of the current state.
+/// @throw std::runtime_error if the file can't be written.
+void write_session(std::string const& file,
+                   std::vector<Session_State> const& states,
+                   std::size_t now);
+
+/// A session file mapped into memory. Tiles and placements are read straight from the
+/// mapped pages without copying.
+class Session_File
+{
+public:
+    /// Map the file and check that its size and header are consistent.
+    /// @throw std::runtime_error if the file can't be read or isn't a session file.
+    explicit Session_File(std::string const& file);
+    Session_File(Session_File const&) = delete;
+    Session_File& operator=(Session_File const&) = delete;
+    ~Session_File();
+
+    /// @return The number of saved states.
+    std::size_t num_states() const;
+    /// @return The index of the current state.
+    std::size_t now() const;
+    /// @return The number of views in each state.
+    std::size_t num_views() const;
+
+    /// @return The figure's tiles for a state in ascending order.
+    std::span<Point<int> const> tiles(std::size_t state) const;
+    /// @return The placements of the views for a state.
+    std::span<Placement const> placements(std::size_t state) const;
+    /// @return The index of the focused view for a state.
+    std::size_t focus(std::size_t state) const;
+    /// @return A copy of a state.
+    Session_State state(std::size_t state) const;
+
+private:
+    void* m_data{nullptr};
+    std::size_t m_size{0};
+    Session_Header const* m_header{nullptr};
+    State_Record const* m_states{nullptr};
+    Placement const* m_placements{nullptr};
+    Point<int> const* m_tiles{nullptr};
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SESSION_HH_INCLUDED
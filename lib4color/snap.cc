@@ -0,0 +1,563 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "snap.hh"
+#include "move_hints.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <queue>
+
+// Offsets here are measured to a tile near the middle of the figure instead of to the
+// figure's origin, which may be far away. Then the offsets where views meet are close
+// to zero for every orientation, and rotations barely change them.
+
+/// How two views meet.
+enum class Contact : std::uint8_t
+{
+    none,
+    touch,
+    overlap,
+};
+
+/// The effect of a move on a view: its new orientation and the change in its offset.
+struct Oriented_Move
+{
+    std::size_t orientation;
+    Point<int> shift;
+};
+
+/// @return The effect of each move on a view in each orientation. A move shifts the
+/// offset by the same amount wherever the view is, so it's enough to make the moves on
+/// views placed with no offset.
+std::vector<std::vector<Oriented_Move>> move_table(Figure const& figure, Point<int> center,
+                                                   std::vector<Edit> const& moves)
+{
+    // Figure_View needs a figure it can change. It's not changed here.
+    auto copy{figure};
+    std::vector<std::vector<Oriented_Move>> table;
+    for (auto const& m : orientations)
+    {
+        table.emplace_back();
+        for (auto const& move : moves)
+        {
+            Figure_View view(copy, {0, 0}, black);
+            view.place({m, {0, 0}});
+            make_move(view, move);
+            auto place{view.placement()};
+            // Measure the change to the center's position.
+            auto shift{place(center) - Placement{m, {0, 0}}(center)};
+            table.back().push_back({orientation_index(place.transform), shift});
+        }
+    }
+    return table;
+}
+
+/// The contact between two views for each pair of orientations and each offset of the
+/// second view from the first, and the fewest moves of the two views that make them
+/// touch. Looking up a pair of views is one load instead of a pass over their tiles.
+class Contact_Table
+{
+public:
+    /// The most entries in a table. Tables of big figures cover fewer offsets beyond
+    /// where the views can meet, and moves() falls back to the distance for the rest.
+    static constexpr std::size_t max_size{std::size_t{1} << 24};
+
+    /// Building the table checks the search's limits and stops early if one is reached.
+    /// The table must not be used then.
+    Contact_Table(Figure const& figure, Point<int> center,
+                  std::vector<std::vector<Oriented_Move>> const& table,
+                  Search_Control& control)
+    {
+        std::vector<std::vector<Point<int>>> oriented;
+        int extent{0};
+        for (auto const& m : orientations)
+        {
+            oriented.emplace_back();
+            for (auto const& t : figure.tiles())
+            {
+                auto p{Placement{m, {0, 0}}(t - center)};
+                oriented.back().push_back(p);
+                extent = std::max({extent, std::abs(p.x), std::abs(p.y)});
+            }
+        }
+        m_stride = 1;
+        for (auto const& effects : table)
+            for (auto const& effect : effects)
+                m_stride = std::max({m_stride, std::abs(effect.shift.x),
+                                     std::abs(effect.shift.y)});
+        m_reach = 2*extent + 1;
+        // The views must fit in the table where they meet.
+        auto const max_window{static_cast<int>(std::sqrt(max_size/pairs) - 1)/2};
+        m_window = std::max(std::min(3*m_reach, max_window), m_reach + m_stride);
+        m_return = (m_window + m_stride - m_reach)/m_stride;
+        m_side = 2*m_window + 1;
+        m_contacts.assign(pairs*m_side*m_side, Contact::none);
+
+        // The second view's tile b lands on the first view's tile a when the offset is
+        // a - b. The tiles touch when it's one step from there.
+        std::array<Point<int>, 4> const steps{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+        for (std::size_t o1{0}; o1 < orientations.size(); ++o1)
+            for (std::size_t o2{0}; o2 < orientations.size(); ++o2)
+            {
+                if (!control.check())
+                    return;
+                for (auto const& a : oriented[o1])
+                    for (auto const& b : oriented[o2])
+                        m_contacts[index(o1, o2, a - b)] = Contact::overlap;
+                for (auto const& a : oriented[o1])
+                    for (auto const& b : oriented[o2])
+                        for (auto const& u : steps)
+                            if (auto& c{m_contacts[index(o1, o2, a + u - b)]};
+                                c == Contact::none)
+                                c = Contact::touch;
+            }
+
+        // Find the fewest moves to touching by a breadth-first search back from the
+        // touching states. A move of the first view to shift s takes the offset from
+        // d + s to d, and a move of the second takes it from d - s to d.
+        std::vector<std::vector<Oriented_Move>> sources(orientations.size());
+        for (std::size_t o{0}; o < table.size(); ++o)
+            for (auto const& effect : table[o])
+                sources[effect.orientation].push_back({o, effect.shift});
+        m_moves.assign(m_contacts.size(), unreached);
+        std::deque<std::size_t> queue;
+        for (std::size_t i{0}; i < m_contacts.size(); ++i)
+            if (m_contacts[i] == Contact::touch)
+            {
+                m_moves[i] = 0;
+                queue.push_back(i);
+            }
+        for (std::size_t popped{0}; !queue.empty(); ++popped)
+        {
+            if (popped % 65536 == 0 && !control.check())
+                return;
+            auto i{queue.front()};
+            queue.pop_front();
+            auto o1{i/(m_side*m_side)/orientations.size()};
+            auto o2{i/(m_side*m_side) % orientations.size()};
+            auto c{i % (m_side*m_side)};
+            Point<int> d{static_cast<int>(c % m_side) - m_window,
+                         static_cast<int>(c/m_side) - m_window};
+            auto visit{[&](std::size_t p1, std::size_t p2, Point<int> p) {
+                if (!inside(p))
+                    return;
+                auto j{index(p1, p2, p)};
+                if (m_moves[j] != unreached)
+                    return;
+                m_moves[j] = m_moves[i] + 1;
+                queue.push_back(j);
+            }};
+            for (auto const& source : sources[o1])
+                visit(source.orientation, o2, d + source.shift);
+            for (auto const& source : sources[o2])
+                visit(o1, source.orientation, d - source.shift);
+        }
+    }
+
+    /// @return The contact between views in orientations @p o1 and @p o2 when the
+    /// second one's offset is @p d from the first one's.
+    Contact operator()(std::size_t o1, std::size_t o2, Point<int> d) const
+    {
+        if (!inside(d))
+            return Contact::none;
+        return m_contacts[index(o1, o2, d)];
+    }
+    /// @return A lower bound on the number of moves of the two views that make them
+    /// touch. Exact unless the shortest way leaves the table.
+    int moves(std::size_t o1, std::size_t o2, Point<int> d) const
+    {
+        // Leaving the table and getting back within reach takes at least as many as
+        // the shortest way out plus m_return.
+        auto far{std::max(std::abs(d.x), std::abs(d.y))};
+        if (!inside(d))
+            return (far - m_reach + m_stride - 1)/m_stride;
+        int moves{m_moves[index(o1, o2, d)]};
+        if (moves <= m_return)
+            return moves;
+        return std::min(moves, (m_window + m_stride - far)/m_stride + m_return);
+    }
+
+private:
+    static constexpr std::size_t pairs{orientations.size()*orientations.size()};
+    static constexpr std::uint16_t unreached{std::numeric_limits<std::uint16_t>::max()};
+
+    bool inside(Point<int> d) const
+    {
+        return std::abs(d.x) <= m_window && std::abs(d.y) <= m_window;
+    }
+    std::size_t index(std::size_t o1, std::size_t o2, Point<int> d) const
+    {
+        return ((o1*orientations.size() + o2)*m_side + d.y + m_window)*m_side
+            + d.x + m_window;
+    }
+
+    /// The most a move can change the offset between two views in either direction.
+    int m_stride;
+    /// The largest offset in either direction where the views can meet.
+    int m_reach;
+    /// The largest offset in the table.
+    int m_window;
+    /// The fewest moves from outside the table to within reach.
+    int m_return;
+    int m_side;
+    std::vector<Contact> m_contacts;
+    std::vector<std::uint16_t> m_moves;
+};
+
+// A view's state is packed into a word: its orientation and the shift of its offset
+// from where it started.
+constexpr int shift_bits{14};
+constexpr int shift_bias{1 << (shift_bits - 1)};
+
+std::uint32_t pack(std::size_t orientation, Point<int> shift)
+{
+    return static_cast<std::uint32_t>(orientation)
+        | static_cast<std::uint32_t>(shift.x + shift_bias) << 3
+        | static_cast<std::uint32_t>(shift.y + shift_bias) << (3 + shift_bits);
+}
+
+std::size_t orientation_of(std::uint32_t state)
+{
+    return state & 0x7;
+}
+
+Point<int> shift_of(std::uint32_t state)
+{
+    constexpr std::uint32_t mask{(1 << shift_bits) - 1};
+    return {static_cast<int>((state >> 3) & mask) - shift_bias,
+            static_cast<int>((state >> (3 + shift_bits)) & mask) - shift_bias};
+}
+
+bool can_pack(Point<int> shift)
+{
+    return std::abs(shift.x) < shift_bias && std::abs(shift.y) < shift_bias;
+}
+
+/// An open-addressing hash table from the views' states to node numbers. The states are
+/// kept in the table so that a lookup usually touches one place in memory.
+class State_Table
+{
+public:
+    explicit State_Table(std::size_t views)
+        : m_views{views}
+    {
+        m_words.assign(1024*(m_views + 1), empty);
+    }
+
+    /// Find the node for a state, or add @p node for it if there's none.
+    /// @return The node and true if it was added.
+    std::pair<std::uint32_t, bool> insert(std::uint32_t const* state, std::uint32_t node)
+    {
+        if (2*(m_count + 1) > capacity())
+            grow();
+        auto slot{find(state)};
+        if (slot[m_views] != empty)
+            return {slot[m_views], false};
+        std::copy(state, state + m_views, slot);
+        slot[m_views] = node;
+        ++m_count;
+        return {node, true};
+    }
+
+private:
+    static constexpr std::uint32_t empty{std::numeric_limits<std::uint32_t>::max()};
+
+    std::size_t capacity() const
+    {
+        return m_words.size()/(m_views + 1);
+    }
+    /// @return The slot that holds the state or the empty slot where it goes.
+    std::uint32_t* find(std::uint32_t const* state)
+    {
+        std::uint64_t h{0};
+        for (std::size_t i{0}; i < m_views; ++i)
+            h = (h ^ state[i])*0x9e3779b97f4a7c15;
+        auto mask{capacity() - 1};
+        for (auto i{(h ^ (h >> 32)) & mask};; i = (i + 1) & mask)
+        {
+            auto slot{&m_words[i*(m_views + 1)]};
+            if (slot[m_views] == empty || std::equal(state, state + m_views, slot))
+                return slot;
+        }
+    }
+    /// Double the capacity.
+    void grow()
+    {
+        std::vector<std::uint32_t> old(2*m_words.size(), empty);
+        old.swap(m_words);
+        for (std::size_t i{0}; i < old.size(); i += m_views + 1)
+            if (old[i + m_views] != empty)
+                std::copy(&old[i], &old[i] + m_views + 1, find(&old[i]));
+    }
+
+    std::size_t m_views;
+    std::size_t m_count{0};
+    /// The states and node numbers, m_views + 1 words per slot.
+    std::vector<std::uint32_t> m_words;
+};
+
+/// A layout reached by the search. Its views' states are stored separately.
+struct Snap_Node
+{
+    /// The node this one was reached from.
+    std::uint32_t parent;
+    /// The number of moves from the start.
+    std::uint32_t moves;
+    /// A lower bound on the number of moves left. Zero only for a map.
+    std::uint32_t left;
+    /// The move that reached this node.
+    std::uint32_t view;
+    std::uint32_t move;
+};
+
+/// An entry in the A* open list.
+struct Snap_Entry
+{
+    std::uint32_t estimate;
+    std::uint32_t moves;
+    std::uint32_t node;
+
+    /// Order for a max-heap: the smallest estimate on top. Break ties with the most
+    /// moves made, which tends to reach a goal sooner.
+    bool operator<(Snap_Entry const& other) const
+    {
+        return estimate > other.estimate
+            || (estimate == other.estimate && moves < other.moves);
+    }
+};
+
+Snap_Result snap_to_map(Layout const& layout, Search_Limits const& limits)
+{
+    Search_Control control{limits};
+    Snap_Result result;
+    auto const& tiles{layout.figure.tiles()};
+    auto const& start{layout.placements};
+    auto const k{start.size()};
+    if (tiles.empty() || k == 0)
+    {
+        result.stats = control.stats(0, 1.0);
+        return result;
+    }
+
+    auto box{bounds(tiles)};
+    Point<int> center{(box.low.x + box.high.x)/2, (box.low.y + box.high.y)/2};
+    auto const moves{single_moves()};
+    auto const table{move_table(layout.figure, center, moves)};
+    Contact_Table contacts{layout.figure, center, table, control};
+    if (!control.check())
+    {
+        result.stats = control.stats(0, 0.0);
+        return result;
+    }
+
+    // The views' states for each node, k words per node.
+    std::vector<std::uint32_t> states;
+    std::vector<Snap_Node> nodes;
+    // Each pair of views needs at least the moves that make the two touch. Moves of
+    // one view count toward all of its pairs, so a group of views whose pairs need a
+    // total of n moves needs at least n/(size - 1) moves of its views. Groups that
+    // share no views need separate moves, so the best partition into groups gives the
+    // estimate. Each term changes by at most one per move, which keeps it consistent.
+    std::vector<Point<int>> origins;
+    for (auto const& place : start)
+        origins.push_back(place(center));
+    std::vector<std::uint32_t> pair_moves(k*k);
+    std::vector<std::uint32_t> group_sum(std::size_t{1} << k);
+    std::vector<std::uint32_t> group_moves(std::size_t{1} << k);
+    std::vector<std::uint32_t> best(std::size_t{1} << k);
+    auto moves_left{[&](std::uint32_t const* s) {
+        for (std::size_t i{0}; i < k; ++i)
+            for (auto j{i + 1}; j < k; ++j)
+                pair_moves[i*k + j] = contacts.moves(
+                    orientation_of(s[i]), orientation_of(s[j]),
+                    origins[j] + shift_of(s[j]) - origins[i] - shift_of(s[i]));
+        for (std::size_t group{1}; group < group_sum.size(); ++group)
+        {
+            auto i{static_cast<std::size_t>(std::countr_zero(group))};
+            auto rest{group & (group - 1)};
+            group_sum[group] = group_sum[rest];
+            for (auto j{i + 1}; j < k; ++j)
+                if (rest & (std::size_t{1} << j))
+                    group_sum[group] += pair_moves[i*k + j];
+            if (auto size{std::popcount(group)}; size > 1)
+                group_moves[group] = (group_sum[group] + size - 2)/(size - 1);
+        }
+        for (std::size_t mask{1}; mask < best.size(); ++mask)
+        {
+            // Choose the group that holds the lowest view in the mask.
+            auto low{mask & -mask};
+            auto rest{mask ^ low};
+            best[mask] = best[rest];
+            for (auto sub{rest}; sub != 0; sub = (sub - 1) & rest)
+                best[mask] = std::max(best[mask],
+                                      group_moves[sub | low] + best[rest ^ sub]);
+        }
+        return best.back();
+    }};
+
+    State_Table seen{k};
+    std::priority_queue<Snap_Entry> open;
+
+    for (std::size_t v{0}; v < k; ++v)
+        states.push_back(pack(orientation_index(start[v].transform), {0, 0}));
+    auto left{moves_left(states.data())};
+    nodes.push_back({std::numeric_limits<std::uint32_t>::max(), 0, left, 0, 0});
+    seen.insert(states.data(), 0);
+    open.push({left, 0, 0});
+
+    Search_Control::Counter counter;
+    std::optional<std::uint32_t> goal;
+    std::vector<std::uint32_t> current(k);
+    std::vector<std::uint32_t> next(k);
+    while (!open.empty())
+    {
+        auto entry{open.top()};
+        open.pop();
+        auto const node{nodes[entry.node]};
+        if (entry.moves > node.moves)
+            continue; // Reached by a shorter path since it was queued.
+        if (node.left == 0)
+        {
+            goal = entry.node;
+            break;
+        }
+        if (!control.visit(counter))
+            break;
+
+        std::copy(&states[entry.node*k], &states[entry.node*k] + k, current.begin());
+        for (std::size_t v{0}; v < k; ++v)
+        {
+            auto const& effects{table[orientation_of(current[v])]};
+            for (std::size_t m{0}; m < moves.size(); ++m)
+            {
+                auto shift{shift_of(current[v]) + effects[m].shift};
+                if (!can_pack(shift))
+                    continue;
+                next = current;
+                next[v] = pack(effects[m].orientation, shift);
+
+                Snap_Node reached{entry.node, node.moves + 1, moves_left(next.data()),
+                                  static_cast<std::uint32_t>(v),
+                                  static_cast<std::uint32_t>(m)};
+                auto [n, added]{seen.insert(next.data(),
+                                            static_cast<std::uint32_t>(nodes.size()))};
+                if (added)
+                {
+                    states.insert(states.end(), next.begin(), next.end());
+                    nodes.push_back(reached);
+                }
+                else if (nodes[n].moves > reached.moves)
+                    nodes[n] = reached;
+                else
+                    continue;
+                open.push({reached.moves + reached.left, reached.moves, n});
+            }
+        }
+    }
+    control.flush(counter);
+
+    result.found = goal.has_value();
+    result.stats = control.stats(result.found ? 1 : 0,
+                                 result.found || open.empty() ? 1.0 : 0.0);
+    if (!goal)
+        return result;
+    for (std::size_t v{0}; v < k; ++v)
+    {
+        auto state{states[*goal*k + v]};
+        Placement place{orientations[orientation_of(state)], {0, 0}};
+        place.offset = origins[v] + shift_of(state) - place(center);
+        result.placements.push_back(place);
+    }
+    for (auto n{*goal}; n != 0; n = nodes[n].parent)
+        result.moves.push_back({nodes[n].view, moves[nodes[n].move]});
+    std::reverse(result.moves.begin(), result.moves.end());
+    return result;
+}
+
+Snapper::Snapper(std::function<void()> notify)
+    : m_notify{std::move(notify)},
+      m_worker{&Snapper::run, this}
+{
+}
+
+Snapper::~Snapper()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+        m_snap_stop.request_stop();
+    }
+    m_wake.notify_one();
+    m_worker.join();
+}
+
+std::uint64_t Snapper::request(Layout layout, Search_Limits limits)
+{
+    std::uint64_t generation;
+    {
+        std::lock_guard lock{m_mutex};
+        m_snap_stop.request_stop();
+        m_pending = std::move(layout);
+        m_pending_limits = limits;
+        generation = ++m_generation;
+    }
+    m_wake.notify_one();
+    return generation;
+}
+
+std::optional<Snap_Result> Snapper::result(std::uint64_t generation) const
+{
+    std::lock_guard lock{m_mutex};
+    if (m_result_generation != generation)
+        return std::nullopt;
+    return m_result;
+}
+
+void Snapper::run()
+{
+    while (true)
+    {
+        std::unique_lock lock{m_mutex};
+        m_wake.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop)
+            return;
+        auto const layout{std::move(*m_pending)};
+        auto limits{m_pending_limits};
+        auto generation{m_generation};
+        m_pending.reset();
+        m_snap_stop = std::stop_source{};
+        limits.stop = m_snap_stop.get_token();
+        lock.unlock();
+
+        auto result{snap_to_map(layout, limits)};
+
+        lock.lock();
+        // A snap stopped for a newer request isn't wanted.
+        if (generation == m_generation)
+        {
+            m_result = std::move(result);
+            m_result_generation = generation;
+        }
+        lock.unlock();
+        if (m_notify)
+            m_notify();
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SNAP_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SNAP_HH_INCLUDED
+
+#include "journal.hh"
+#include "layout.hh"
+#include "search_control.hh"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+/// A single-step move of one view.
+struct View_Move
+{
+    std::size_t view;
+    Edit move;
+};
+
+/// The result of snap_to_map().
+struct Snap_Result
+{
+    /// True if a map was reached.
+    bool found{false};
+    /// The moves that reach the map, in the order they're made.
+    std::vector<View_Move> moves;
+    /// The placements of the views after the moves.
+    std::vector<Placement> placements;
+    /// A node is a layout whose moves were tried.
+    Search_Stats stats;
+};
+
+/// Find the shortest sequence of single-step moves of the views that makes a map, where
+/// no two views overlap and each shares an edge with all the others. A move is one of
+/// single_moves() made on one view the way Figure_View makes it. The search is A*. The
+/// heuristic takes the fewest moves that make each pair of views touch, bounds the moves
+/// needed by each group of views from its pairs' total, and adds up the bounds of the
+/// best partition of the views into groups.
+Snap_Result snap_to_map(Layout const& layout, Search_Limits const& limits = {});
+
+/// Snaps layouts on a background thread so the caller doesn't wait. A new request stops
+/// the snap in progress.
+class Snapper
+{
+public:
+    /// @param notify Called on the worker thread when a snap finishes.
+    explicit Snapper(std::function<void()> notify = {});
+    /// Stop the snap in progress and the worker.
+    ~Snapper();
+
+    /// Start snapping a layout, stopping the snap in progress.
+    /// @param limits The limits of the snap. Its stop token is replaced.
+    /// @return The generation number of the request.
+    std::uint64_t request(Layout layout, Search_Limits limits);
+    /// @return The result of the request with the given generation if it's ready.
+    std::optional<Snap_Result> result(std::uint64_t generation) const;
+
+private:
+    /// Snap layouts until stopped.
+    void run();
+
+    std::function<void()> m_notify;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<Layout> m_pending;
+    Search_Limits m_pending_limits;
+    std::uint64_t m_generation{0};
+    /// Stops the snap in progress.
+    std::stop_source m_snap_stop;
+    /// The most recent result and the request it's for.
+    Snap_Result m_result;
+    std::uint64_t m_result_generation{0};
+    bool m_stop{false};
+    /// The worker is started last and stopped first.
+    std::thread m_worker;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SNAP_HH_INCLUDED
@@ -0,0 +1,302 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "solution_cache.hh"
+#include "layout.hh"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+static_assert(sizeof(Cache_Header) == 56);
+static_assert(sizeof(Cache_Slot) == 32);
+static_assert(sizeof(Cache_Entry) == 24);
+
+constexpr char cache_magic[8]{'4', 'c', 'o', 'l', 'o', 'r', 'K', '\n'};
+constexpr std::uint32_t cache_version{1};
+
+/// Holds an flock() on a file for the life of the object.
+class File_Lock
+{
+public:
+    /// @param operation LOCK_SH or LOCK_EX
+    File_Lock(int fd, int operation)
+        : m_fd{fd}
+    {
+        ::flock(m_fd, operation);
+    }
+    ~File_Lock()
+    {
+        ::flock(m_fd, LOCK_UN);
+    }
+
+private:
+    int m_fd;
+};
+
+/// @return The size rounded up to keep entries 8-byte aligned.
+std::uint64_t aligned(std::uint64_t size)
+{
+    return (size + 7) & ~std::uint64_t{7};
+}
+
+/// @return The current clock value after advancing it.
+std::uint64_t tick(Cache_Header& header)
+{
+    return std::atomic_ref{header.clock}.fetch_add(1) + 1;
+}
+
+Solution_Cache::Solution_Cache(std::string const& file, Cache_Options const& options)
+    : m_max_solutions{options.max_solutions},
+      m_fd{::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)}
+{
+    if (m_fd < 0)
+        throw std::runtime_error("Can't open cache " + file);
+
+    File_Lock lock{m_fd, LOCK_EX};
+    Cache_Header header{};
+    struct stat info;
+    auto valid{::fstat(m_fd, &info) == 0
+               && ::pread(m_fd, &header, sizeof(header), 0) == sizeof(header)
+               && std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0
+               && header.version == cache_version
+               && std::has_single_bit(header.num_slots)
+               && header.capacity % 8 == 0
+               && static_cast<std::uint64_t>(info.st_size)
+                  == sizeof(Cache_Header) + header.num_slots*sizeof(Cache_Slot)
+                     + header.capacity};
+    if (!valid)
+    {
+        // Start over with an empty cache.
+        header = Cache_Header{};
+        std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.version = cache_version;
+        header.num_slots = std::bit_ceil(2*std::max<std::size_t>(options.max_entries, 1));
+        header.capacity = aligned(options.max_bytes);
+        auto size{sizeof(Cache_Header) + header.num_slots*sizeof(Cache_Slot)
+                  + header.capacity};
+        if (::ftruncate(m_fd, 0) != 0
+            || ::ftruncate(m_fd, size) != 0
+            || ::pwrite(m_fd, &header, sizeof(header), 0) != sizeof(header))
+        {
+            ::close(m_fd);
+            throw std::runtime_error("Can't create cache " + file);
+        }
+    }
+    m_size = sizeof(Cache_Header) + header.num_slots*sizeof(Cache_Slot) + header.capacity;
+    m_data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_data == MAP_FAILED)
+    {
+        m_data = nullptr;
+        ::close(m_fd);
+        throw std::runtime_error("Can't map cache " + file);
+    }
+    m_header = static_cast<Cache_Header*>(m_data);
+    m_slots = reinterpret_cast<Cache_Slot*>(m_header + 1);
+    m_heap = reinterpret_cast<char*>(m_slots + m_header->num_slots);
+}
+
+Solution_Cache::~Solution_Cache()
+{
+    ::munmap(m_data, m_size);
+    ::close(m_fd);
+}
+
+Cache_Entry const* Solution_Cache::entry(Cache_Slot const& slot) const
+{
+    // Don't trust the file to keep reads inside the heap.
+    if (slot.offset % 8 != 0
+        || slot.size < sizeof(Cache_Entry)
+        || slot.offset > m_header->capacity
+        || slot.size > m_header->capacity - slot.offset)
+        return nullptr;
+    auto e{reinterpret_cast<Cache_Entry const*>(m_heap + slot.offset)};
+    auto size{sizeof(Cache_Entry)
+              + std::uint64_t{e->num_tiles}*sizeof(Point<int>)
+              + e->num_stored*e->copies*sizeof(Placement)};
+    return size == slot.size ? e : nullptr;
+}
+
+Cache_Slot* Solution_Cache::lookup(std::uint64_t hash,
+                                   std::vector<Point<int>> const& tiles) const
+{
+    auto mask{m_header->num_slots - 1};
+    auto i{hash & mask};
+    for (std::size_t probe{0}; probe <= mask && m_slots[i].size != 0;
+         ++probe, i = (i + 1) & mask)
+    {
+        if (m_slots[i].hash != hash)
+            continue;
+        auto e{entry(m_slots[i])};
+        if (e && e->num_tiles == tiles.size()
+            && std::memcmp(e + 1, tiles.data(), tiles.size()*sizeof(Point<int>)) == 0)
+            return &m_slots[i];
+    }
+    return nullptr;
+}
+
+std::optional<std::size_t> Solution_Cache::count(Figure const& figure) const
+{
+    auto form{canonical_form(figure)};
+    auto hash{canonical_hash(form)};
+    std::shared_lock lock{m_mutex};
+    File_Lock file_lock{m_fd, LOCK_SH};
+    auto slot{lookup(hash, form.tiles)};
+    if (!slot)
+        return std::nullopt;
+    return entry(*slot)->num_solutions;
+}
+
+std::optional<Cached_Result> Solution_Cache::find(Figure const& figure) const
+{
+    auto form{canonical_form(figure)};
+    auto hash{canonical_hash(form)};
+    std::shared_lock lock{m_mutex};
+    File_Lock file_lock{m_fd, LOCK_SH};
+    auto slot{lookup(hash, form.tiles)};
+    if (!slot)
+        return std::nullopt;
+    // Other readers may be touching entries too.
+    std::atomic_ref{slot->last_used}.store(tick(*m_header));
+
+    auto e{entry(*slot)};
+    Cached_Result result{e->num_solutions, {}};
+    auto place{reinterpret_cast<Placement const*>(
+            reinterpret_cast<Point<int> const*>(e + 1) + e->num_tiles)};
+    for (std::size_t i{0}; i < e->num_stored; ++i)
+    {
+        Solution solution;
+        for (std::size_t c{0}; c < e->copies; ++c)
+            solution.push_back(from_canonical(form, *place++));
+        result.solutions.push_back(std::move(solution));
+    }
+    return result;
+}
+
+void Solution_Cache::clear()
+{
+    std::memset(m_slots, 0, m_header->num_slots*sizeof(Cache_Slot));
+    m_header->used = 0;
+    m_header->num_entries = 0;
+}
+
+bool Solution_Cache::insert(std::uint64_t hash, std::string const& bytes,
+                            std::uint64_t last_used)
+{
+    if (2*(m_header->num_entries + 1) > m_header->num_slots
+        || bytes.size() > m_header->capacity - m_header->used)
+        return false;
+    auto mask{m_header->num_slots - 1};
+    auto i{hash & mask};
+    while (m_slots[i].size != 0)
+        i = (i + 1) & mask;
+    std::memcpy(m_heap + m_header->used, bytes.data(), bytes.size());
+    m_slots[i] = {hash, m_header->used, bytes.size(), last_used};
+    m_header->used += aligned(bytes.size());
+    ++m_header->num_entries;
+    return true;
+}
+
+bool Solution_Cache::replace(Cache_Slot& slot, std::string const& bytes)
+{
+    // Overwrite the entry if the new one fits in its space. Otherwise put it at the end
+    // of the heap. The old bytes are unused until the next rebuild.
+    auto offset{slot.offset};
+    if (aligned(bytes.size()) > aligned(slot.size))
+    {
+        if (bytes.size() > m_header->capacity - m_header->used)
+            return false;
+        offset = m_header->used;
+        m_header->used += aligned(bytes.size());
+    }
+    std::memcpy(m_heap + offset, bytes.data(), bytes.size());
+    slot.offset = offset;
+    slot.size = bytes.size();
+    slot.last_used = tick(*m_header);
+    return true;
+}
+
+void Solution_Cache::store(Figure const& figure, std::size_t count,
+                           std::vector<Solution> const& solutions)
+{
+    auto form{canonical_form(figure)};
+    auto hash{canonical_hash(form)};
+    Cache_Entry header{count, static_cast<std::uint32_t>(form.tiles.size()),
+                       static_cast<std::uint32_t>(solutions.empty()
+                                                  ? 0 : solutions.front().size()),
+                       std::min(solutions.size(), m_max_solutions)};
+    std::string bytes(reinterpret_cast<char const*>(&header), sizeof(header));
+    bytes.append(reinterpret_cast<char const*>(form.tiles.data()),
+                 form.tiles.size()*sizeof(Point<int>));
+    for (std::size_t i{0}; i < header.num_stored; ++i)
+        for (auto const& place : solutions[i])
+        {
+            auto p{to_canonical(form, place)};
+            bytes.append(reinterpret_cast<char const*>(&p), sizeof(p));
+        }
+
+    std::unique_lock lock{m_mutex};
+    File_Lock file_lock{m_fd, LOCK_EX};
+    auto old{lookup(hash, form.tiles)};
+    if (!old && insert(hash, bytes, tick(*m_header)))
+        return;
+    if (old && replace(*old, bytes))
+        return;
+
+    // Rebuild the cache with the new entry and as many of the most recently used old
+    // ones as fit in 3/4 of the space so the next few stores are quick.
+    struct Old_Entry
+    {
+        std::uint64_t hash;
+        std::uint64_t last_used;
+        std::string bytes;
+    };
+    std::vector<Old_Entry> keep;
+    for (std::size_t i{0}; i < m_header->num_slots; ++i)
+        if (m_slots[i].size != 0 && &m_slots[i] != old && entry(m_slots[i]))
+            keep.push_back({m_slots[i].hash, m_slots[i].last_used,
+                            {m_heap + m_slots[i].offset, m_slots[i].size}});
+    std::sort(keep.begin(), keep.end(),
+              [](auto const& e1, auto const& e2) { return e1.last_used > e2.last_used; });
+    clear();
+    if (!insert(hash, bytes, tick(*m_header)))
+        std::cerr << "Too many solutions to cache" << std::endl;
+    for (auto const& e : keep)
+        if (4*(m_header->used + aligned(e.bytes.size())) > 3*m_header->capacity
+            || 8*(m_header->num_entries + 1) > 3*m_header->num_slots
+            || !insert(e.hash, e.bytes, e.last_used))
+            break;
+}
+
+std::size_t Solution_Cache::size() const
+{
+    std::shared_lock lock{m_mutex};
+    File_Lock file_lock{m_fd, LOCK_SH};
+    return m_header->num_entries;
+}
+
+std::size_t Solution_Cache::max_solutions() const
+{
+    return m_max_solutions;
+}
@@ -0,0 +1,146 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SOLUTION_CACHE_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SOLUTION_CACHE_HH_INCLUDED
+
+#include "figure.hh"
+#include "search.hh"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// A cache file is a fixed-size hash table of figures and the maps found for them. It's
+// mapped shared so that several processes see the same entries. Readers hold a shared
+// lock on the file and writers an exclusive one. Everything is native-endian, so the
+// file is only good on the machine that wrote it.
+//
+//   Cache_Header
+//   Cache_Slot[num_slots]  Open addressing with linear probing.
+//   Entry heap[capacity]   Cache_Entry, canonical tiles, placements.
+//
+// Placements are stored in the canonical frame, so a figure finds its maps after being
+// moved or rotated.
+
+struct Cache_Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t num_slots;
+    /// The size of the entry heap in bytes.
+    std::uint64_t capacity;
+    /// The bytes in use at the start of the heap.
+    std::uint64_t used;
+    /// Incremented on each access. Used to find the least recently used entries.
+    std::uint64_t clock;
+    std::uint64_t num_entries;
+};
+
+struct Cache_Slot
+{
+    std::uint64_t hash;
+    /// The position of the entry in the heap.
+    std::uint64_t offset;
+    /// The size of the entry in bytes. Zero for an empty slot.
+    std::uint64_t size;
+    /// The clock value when the entry was last read or written.
+    std::uint64_t last_used;
+};
+
+struct Cache_Entry
+{
+    /// The number of maps found. More than are stored if the search found many.
+    std::uint64_t num_solutions;
+    std::uint32_t num_tiles;
+    std::uint32_t copies;
+    /// The number of maps whose placements follow the tiles.
+    std::uint64_t num_stored;
+};
+
+/// The size limits of a new cache file. An existing file keeps its own.
+struct Cache_Options
+{
+    std::size_t max_entries{4096};
+    std::size_t max_bytes{64 << 20};
+    /// The most maps stored for one figure.
+    std::size_t max_solutions{1024};
+};
+
+/// What's known about a figure.
+struct Cached_Result
+{
+    /// The number of maps.
+    std::size_t count{0};
+    /// Some or all of the maps, with placements of the figure's tiles.
+    std::vector<Solution> solutions;
+};
+
+/// An on-disk store of search results keyed by the figure's canonical hash. When full,
+/// the least recently used entries are removed to make room. Safe to use from several
+/// threads and processes.
+class Solution_Cache
+{
+public:
+    /// Map the cache file, creating it if it doesn't exist or isn't valid.
+    /// @throw std::runtime_error if the file can't be created or mapped.
+    explicit Solution_Cache(std::string const& file, Cache_Options const& options = {});
+    Solution_Cache(Solution_Cache const&) = delete;
+    Solution_Cache& operator=(Solution_Cache const&) = delete;
+    ~Solution_Cache();
+
+    /// @return The number of maps for the figure, if it has been searched.
+    std::optional<std::size_t> count(Figure const& figure) const;
+    /// @return The stored results for the figure, if it has been searched.
+    std::optional<Cached_Result> find(Figure const& figure) const;
+    /// Add or replace the results for a figure. At most options.max_solutions maps are
+    /// kept.
+    void store(Figure const& figure, std::size_t count, std::vector<Solution> const& solutions);
+    /// @return The number of figures in the cache.
+    std::size_t size() const;
+    /// @return The most maps stored for one figure.
+    std::size_t max_solutions() const;
+
+private:
+    /// @return The slot holding the canonical tiles or nullptr if they aren't cached.
+    /// The caller must hold a lock.
+    Cache_Slot* lookup(std::uint64_t hash, std::vector<Point<int>> const& tiles) const;
+    /// @return The entry in a slot or nullptr if the slot's bounds are bad.
+    Cache_Entry const* entry(Cache_Slot const& slot) const;
+    /// Empty the table and heap. The caller must hold an exclusive lock.
+    void clear();
+    /// Add an entry to the heap and table. The caller must hold an exclusive lock.
+    /// @return False if there's no room.
+    bool insert(std::uint64_t hash, std::string const& bytes, std::uint64_t last_used);
+    /// Put new bytes in an existing entry. The caller must hold an exclusive lock.
+    /// @return False if there's no room.
+    bool replace(Cache_Slot& slot, std::string const& bytes);
+
+    std::size_t m_max_solutions;
+    int m_fd{-1};
+    void* m_data{nullptr};
+    std::size_t m_size{0};
+    Cache_Header* m_header{nullptr};
+    Cache_Slot* m_slots{nullptr};
+    char* m_heap{nullptr};
+    /// File locks don't exclude threads that share the descriptor.
+    mutable std::shared_mutex m_mutex;
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SOLUTION_CACHE_HH_INCLUDED
@@ -0,0 +1,355 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "solution_writer.hh"
+
+#include <zlib.h>
+#ifdef FOUR_COLOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+static_assert(sizeof(Solution_Header) == 24);
+
+constexpr char solution_magic[8]{'4', 'c', 'o', 'l', 'o', 'r', 'M', '\n'};
+constexpr std::uint32_t solution_version{1};
+/// The size of the fields before the tile bitmap: tile count, width, and height.
+constexpr std::size_t shape_size{4};
+/// The size of a binary placement: orientation and offset.
+constexpr std::size_t placement_size{5};
+
+std::size_t bitmap_size(int max_extent)
+{
+    return (max_extent*max_extent + 7)/8;
+}
+
+/// Append the bytes of a value to a buffer.
+template <typename T> void put(std::string& buffer, T value)
+{
+    buffer.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+/// Copy a value from a buffer.
+template <typename T> T get(char const* bytes)
+{
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+void put_ndjson(std::string& buffer,
+                Canonical_Form const& shape,
+                std::vector<Placement> const& placements)
+{
+    buffer += "{\"tiles\":[";
+    for (auto const& p : shape.tiles)
+    {
+        if (&p != &shape.tiles.front())
+            buffer += ',';
+        buffer += '[' + std::to_string(p.x) + ',' + std::to_string(p.y) + ']';
+    }
+    buffer += "],\"views\":[";
+    for (auto const& place : placements)
+    {
+        if (&place != &placements.front())
+            buffer += ',';
+        buffer += '[' + std::to_string(orientation_index(place.transform))
+            + ',' + std::to_string(place.offset.x)
+            + ',' + std::to_string(place.offset.y) + ']';
+    }
+    buffer += "]}\n";
+}
+
+void put_binary(std::string& buffer,
+                Canonical_Form const& shape,
+                std::vector<Placement> const& placements,
+                Writer_Options const& options)
+{
+    Point<int> size{0, 0};
+    for (auto const& p : shape.tiles)
+        size = {std::max(size.x, p.x + 1), std::max(size.y, p.y + 1)};
+    if (size.x > options.max_extent || size.y > options.max_extent)
+        throw std::runtime_error("Figure is too big for a solution record");
+    if (placements.size() != options.copies)
+        throw std::runtime_error("Wrong number of copies for a solution record");
+    // Check everything before appending so that an error leaves no partial record.
+    constexpr int low{std::numeric_limits<std::int16_t>::min()};
+    constexpr int high{std::numeric_limits<std::int16_t>::max()};
+    for (auto const& place : placements)
+        if (place.offset.x < low || place.offset.x > high
+            || place.offset.y < low || place.offset.y > high)
+            throw std::runtime_error("Placement is too far for a solution record");
+
+    put<std::uint16_t>(buffer, shape.tiles.size());
+    put<std::uint8_t>(buffer, size.x);
+    put<std::uint8_t>(buffer, size.y);
+    std::string bitmap(bitmap_size(options.max_extent), '\0');
+    for (auto const& p : shape.tiles)
+    {
+        auto bit{p.x + p.y*options.max_extent};
+        bitmap[bit/8] |= 1 << (bit % 8);
+    }
+    buffer += bitmap;
+    for (auto const& place : placements)
+    {
+        put<std::uint8_t>(buffer, orientation_index(place.transform));
+        put<std::int16_t>(buffer, place.offset.x);
+        put<std::int16_t>(buffer, place.offset.y);
+    }
+}
+
+/// @return The data compressed as one gzip member.
+std::string gzip(std::string const& data)
+{
+    z_stream z{};
+    // 16 selects a gzip wrapper instead of zlib.
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Can't start gzip compression");
+    std::string out(deflateBound(&z, data.size()), '\0');
+    z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    z.avail_in = data.size();
+    z.next_out = reinterpret_cast<Bytef*>(out.data());
+    z.avail_out = out.size();
+    auto status{deflate(&z, Z_FINISH)};
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    if (status != Z_STREAM_END)
+        throw std::runtime_error("gzip compression failed");
+    return out;
+}
+
+#ifdef FOUR_COLOR_HAVE_ZSTD
+constexpr bool have_zstd{true};
+
+/// @return The data compressed as one zstd frame.
+std::string zstd(std::string const& data)
+{
+    std::string out(ZSTD_compressBound(data.size()), '\0');
+    auto n{ZSTD_compress(out.data(), out.size(), data.data(), data.size(), 3)};
+    if (ZSTD_isError(n))
+        throw std::runtime_error(std::string{"zstd compression failed: "}
+                                 + ZSTD_getErrorName(n));
+    out.resize(n);
+    return out;
+}
+#else
+constexpr bool have_zstd{false};
+#endif
+
+bool has_compression(Compression compression)
+{
+    return compression != Compression::zstd || have_zstd;
+}
+
+Solution_Writer::Solution_Writer(std::string const& file, Writer_Options const& options)
+    : m_options{options},
+      m_os{file, std::ios::binary | std::ios::trunc},
+      m_buffers(std::max(1u, options.threads))
+{
+    if (!has_compression(m_options.compression))
+        throw std::runtime_error("zstd compression is not available");
+    if (!m_os)
+        throw std::runtime_error("Can't open " + file + " for writing");
+    for (auto& buffer : m_buffers)
+        buffer.data.reserve(m_options.block_size + 4096);
+    if (m_options.format == Solution_Format::binary)
+    {
+        m_record_size = shape_size + bitmap_size(m_options.max_extent)
+            + m_options.copies*placement_size;
+        Solution_Header header{};
+        std::memcpy(header.magic, solution_magic, sizeof(solution_magic));
+        header.version = solution_version;
+        header.record_size = m_record_size;
+        header.max_extent = m_options.max_extent;
+        header.copies = m_options.copies;
+        put(m_buffers.front().data, header);
+    }
+}
+
+Solution_Writer::~Solution_Writer()
+{
+    try
+    {
+        flush();
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void Solution_Writer::write(unsigned thread, Canonical_Form const& shape,
+                            Solution const& solution)
+{
+    assert(thread < m_buffers.size());
+    std::vector<Placement> placements;
+    placements.reserve(solution.size());
+    for (auto const& place : solution)
+        placements.push_back(to_canonical(shape, place));
+
+    auto& buffer{m_buffers[thread].data};
+    if (m_options.format == Solution_Format::binary)
+        put_binary(buffer, shape, placements, m_options);
+    else
+        put_ndjson(buffer, shape, placements);
+    if (buffer.size() >= m_options.block_size)
+        flush(buffer);
+}
+
+void Solution_Writer::flush()
+{
+    for (auto& buffer : m_buffers)
+        flush(buffer.data);
+}
+
+void Solution_Writer::flush(std::string& buffer)
+{
+    if (buffer.empty())
+        return;
+    // Compress outside of the lock so threads can compress in parallel.
+    std::string packed;
+    if (m_options.compression == Compression::gzip)
+        packed = gzip(buffer);
+#ifdef FOUR_COLOR_HAVE_ZSTD
+    else if (m_options.compression == Compression::zstd)
+        packed = zstd(buffer);
+#endif
+    auto const& out{m_options.compression == Compression::none ? buffer : packed};
+    {
+        std::lock_guard lock{m_mutex};
+        m_os.write(out.data(), out.size());
+        m_os.flush();
+    }
+    buffer.clear();
+    if (!m_os)
+        throw std::runtime_error("Failed to write solutions");
+}
+
+Solution_Handler Solution_Writer::handler(Figure const& figure)
+{
+    return [this, shape = canonical_form(figure)](unsigned thread, Solution const& solution) {
+        write(thread, shape, solution);
+    };
+}
+
+/// @return The decompressed contents of a file.
+std::string read_all(std::string const& file)
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> in{std::fopen(file.c_str(), "rb"),
+                                                         &std::fclose};
+    if (!in)
+        throw std::runtime_error("Can't open " + file);
+    std::string raw;
+    char chunk[1 << 16];
+    for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), in.get())) > 0;)
+        raw.append(chunk, n);
+
+    constexpr unsigned char zstd_magic[4]{0x28, 0xb5, 0x2f, 0xfd};
+    if (raw.size() >= 4 && std::memcmp(raw.data(), zstd_magic, 4) == 0)
+    {
+#ifdef FOUR_COLOR_HAVE_ZSTD
+        std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> z{ZSTD_createDStream(),
+                                                                   &ZSTD_freeDStream};
+        ZSTD_initDStream(z.get());
+        std::string out;
+        ZSTD_inBuffer zin{raw.data(), raw.size(), 0};
+        while (zin.pos < zin.size)
+        {
+            ZSTD_outBuffer zout{chunk, sizeof(chunk), 0};
+            auto status{ZSTD_decompressStream(z.get(), &zout, &zin)};
+            if (ZSTD_isError(status))
+                throw std::runtime_error("Failed to decompress " + file);
+            out.append(chunk, zout.pos);
+        }
+        return out;
+#else
+        throw std::runtime_error("zstd compression is not available");
+#endif
+    }
+
+    if (raw.size() < 2 || static_cast<unsigned char>(raw[0]) != 0x1f
+        || static_cast<unsigned char>(raw[1]) != 0x8b)
+        return raw;
+
+    // Inflate each of the concatenated gzip members.
+    z_stream z{};
+    if (inflateInit2(&z, 15 + 16) != Z_OK)
+        throw std::runtime_error("Can't start decompression");
+    std::string out;
+    z.next_in = reinterpret_cast<Bytef*>(raw.data());
+    z.avail_in = raw.size();
+    do
+    {
+        z.next_out = reinterpret_cast<Bytef*>(chunk);
+        z.avail_out = sizeof(chunk);
+        auto status{inflate(&z, Z_NO_FLUSH)};
+        // A buffer error means there's no more input to use.
+        if (status == Z_BUF_ERROR)
+            break;
+        if (status != Z_OK && status != Z_STREAM_END)
+        {
+            inflateEnd(&z);
+            throw std::runtime_error("Failed to decompress " + file);
+        }
+        out.append(chunk, sizeof(chunk) - z.avail_out);
+        if (status == Z_STREAM_END)
+            inflateReset(&z);
+    } while (z.avail_in > 0 || z.avail_out == 0);
+    inflateEnd(&z);
+    return out;
+}
+
+std::vector<Solution_Record> read_solutions(std::string const& file)
+{
+    auto data{read_all(file)};
+    if (data.size() < sizeof(Solution_Header))
+        throw std::runtime_error(file + " is not a solution file");
+    auto header{get<Solution_Header>(data.data())};
+    if (std::memcmp(header.magic, solution_magic, sizeof(solution_magic)) != 0
+        || header.version != solution_version
+        || header.record_size != shape_size + bitmap_size(header.max_extent)
+           + header.copies*placement_size
+        || (data.size() - sizeof(Solution_Header)) % header.record_size != 0)
+        throw std::runtime_error(file + " is not a solution file");
+
+    std::vector<Solution_Record> records;
+    for (auto record{data.data() + sizeof(Solution_Header)};
+         record < data.data() + data.size();
+         record += header.record_size)
+    {
+        Solution_Record solution;
+        auto bitmap{record + shape_size};
+        int extent = header.max_extent;
+        for (auto bit{0}; bit < extent*extent; ++bit)
+            if (bitmap[bit/8] >> (bit % 8) & 1)
+                solution.tiles.push_back({bit % extent, bit/extent});
+        std::sort(solution.tiles.begin(), solution.tiles.end());
+        auto place{bitmap + bitmap_size(extent)};
+        for (std::size_t i{0}; i < header.copies; ++i, place += placement_size)
+            solution.placements.push_back(
+                {orientations.at(get<std::uint8_t>(place)),
+                 {get<std::int16_t>(place + 1), get<std::int16_t>(place + 3)}});
+        records.push_back(std::move(solution));
+    }
+    return records;
+}
@@ -0,0 +1,140 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SOLUTION_WRITER_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SOLUTION_WRITER_HH_INCLUDED
+
+#include "layout.hh"
+#include "search.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A solution record holds the canonical tiles of a figure and the placements of its
+// copies in the canonical frame (see to_canonical()), so records of the same map found
+// from different copies of a figure are alike.
+//
+// NDJSON: One object per line.
+//   {"tiles":[[x,y],...],"views":[[orientation,x,y],...]}
+//   The orientation is an index into orientations.
+//
+// Binary: A Solution_Header followed by fixed-width native-endian records.
+//   uint16  Number of tiles
+//   uint8   Width and height of the canonical tiles
+//   bit[max_extent*max_extent]  Tiles, row-major, padded to a whole byte
+//   {uint8 orientation, int16 x, int16 y}[copies]
+//
+// Compressed files are a sequence of independently compressed blocks: gzip members or
+// zstd frames. Standard tools decompress them as one stream.
+
+enum class Solution_Format
+{
+    ndjson,
+    binary,
+};
+
+enum class Compression
+{
+    none,
+    gzip,
+    zstd,
+};
+
+struct Writer_Options
+{
+    Solution_Format format{Solution_Format::ndjson};
+    Compression compression{Compression::none};
+    /// The number of threads that will call write().
+    unsigned threads{1};
+    /// The size of the per-thread buffers. Each is compressed and written when full.
+    std::size_t block_size{1 << 20};
+    /// The number of copies in each solution. Binary only.
+    std::size_t copies{4};
+    /// The largest width or height of a figure. Binary only.
+    int max_extent{16};
+};
+
+/// The start of a binary solution file.
+struct Solution_Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint32_t max_extent;
+    std::uint32_t copies;
+};
+
+/// A solution read back from a binary file.
+struct Solution_Record
+{
+    std::vector<Point<int>> tiles;
+    std::vector<Placement> placements;
+};
+
+/// @return True if the compression method is available in this build.
+bool has_compression(Compression compression);
+
+/// Streams solutions to a file as they're found. Each thread fills its own buffer, and
+/// only full buffers are compressed and appended under a lock, so threads rarely wait on
+/// each other or the disk. The order of solutions from different threads is not kept.
+class Solution_Writer
+{
+public:
+    /// Open the file and write the header.
+    /// @throw std::runtime_error if the file can't be opened or the compression isn't
+    /// available.
+    Solution_Writer(std::string const& file, Writer_Options const& options = {});
+    Solution_Writer(Solution_Writer const&) = delete;
+    Solution_Writer& operator=(Solution_Writer const&) = delete;
+    /// Write what's left in the buffers.
+    ~Solution_Writer();
+
+    /// Add a solution for a figure to a thread's buffer.
+    /// @param thread The index of the calling thread, less than options.threads.
+    /// @param shape The canonical form of the figure the solution's placements apply to.
+    /// @throw std::runtime_error if a binary record can't hold the solution, or if
+    /// writing a full buffer fails.
+    void write(unsigned thread, Canonical_Form const& shape, Solution const& solution);
+    /// Write all buffers. Must not be called while other threads are writing.
+    void flush();
+
+    /// @return A handler for find_maps() that writes the figure's solutions. An error
+    /// from write() stops the search, and find_maps() rethrows it.
+    Solution_Handler handler(Figure const& figure);
+
+private:
+    /// Compress and write a buffer, then empty it.
+    void flush(std::string& buffer);
+
+    Writer_Options m_options;
+    std::size_t m_record_size{0};
+    std::mutex m_mutex;
+    std::ofstream m_os;
+    /// Kept a cache line apart so threads don't contend for them.
+    struct alignas(64) Buffer
+    {
+        std::string data;
+    };
+    std::vector<Buffer> m_buffers;
+};
+
+/// @return The solutions in a binary solution file, uncompressed or compressed.
+/// @throw std::runtime_error if the file can't be read or isn't a binary solution file.
+std::vector<Solution_Record> read_solutions(std::string const& file);
+
+#endif // FOUR_COLOR_LIB4COLOR_SOLUTION_WRITER_HH_INCLUDED
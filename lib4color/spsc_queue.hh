@@ -0,0 +1,70 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of 4color.
+//
+// 4color is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// 4color is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with 4color.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FOUR_COLOR_LIB4COLOR_SPSC_QUEUE_HH_INCLUDED
+#define FOUR_COLOR_LIB4COLOR_SPSC_QUEUE_HH_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <optional>
+#include <vector>
+
+/// A fixed-capacity, lock-free queue for passing values from one producer thread to one
+/// consumer thread.
+template <typename T> class Spsc_Queue
+{
+public:
+    /// @param capacity The most values waiting at once. Rounded up to a power of 2.
+    explicit Spsc_Queue(std::size_t capacity)
+        : m_buffer(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+          m_mask{m_buffer.size() - 1}
+    {
+    }
+
+    /// Add a value to the back of the queue. Called only by the producer.
+    /// @return False if the queue is full. The value is not added.
+    bool push(T value)
+    {
+        auto tail{m_tail.load(std::memory_order_relaxed)};
+        if (tail - m_head.load(std::memory_order_acquire) == m_buffer.size())
+            return false;
+        m_buffer[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Remove the value at the front of the queue. Called only by the consumer.
+    /// @return The value, or nothing if the queue is empty.
+    std::optional<T> pop()
+    {
+        auto head{m_head.load(std::memory_order_relaxed)};
+        if (head == m_tail.load(std::memory_order_acquire))
+            return std::nullopt;
+        std::optional<T> value{std::move(m_buffer[head & m_mask])};
+        m_head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask;
+    /// The count of values popped. Written only by the consumer.
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    /// The count of values pushed. Written only by the producer.
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // FOUR_COLOR_LIB4COLOR_SPSC_QUEUE_HH_INCLUDED
@@ -16,13 +16,51 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 
+#include "bitboard.hh"
+#include "catalog.hh"
+#include "color_search.hh"
+#include "contact.hh"
+#include "exact_cover.hh"
+#include "export_queue.hh"
 #include "figure.hh"
 #include "figure_view.hh"
+#include "holes.hh"
+#include "joint_search.hh"
+#include "journal.hh"
+#include "live_solver.hh"
+#include "local_search.hh"
+#include "move_hints.hh"
+#include "png_reader.hh"
+#include "ranking.hh"
+#include "region_graph.hh"
+#include "render.hh"
+#include "sat_map.hh"
+#include "sat_solver.hh"
+#include "search.hh"
+#include "session.hh"
+#include "snap.hh"
+#include "solution_cache.hh"
+#include "solution_writer.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
 
 #include "doctest.h"
 
 Point<int> here{0, 0};
 
+/// @return The layout in an image in the examples directory.
+Layout example_layout(std::string const& name)
+{
+    return read_png((std::filesystem::path{EXAMPLES_DIR} / name).string());
+}
+
 TEST_CASE("initial figure")
 {
     Figure f;
@@ -266,3 +304,1328 @@ TEST_CASE("view toggle transformed 2")
     view.toggle({0, 1});
     CHECK(same_tiles(view.tiles(), {{0, 0}, {0, 1}})); // fail: shifted (-1, 0)
 }
+
+TEST_CASE("view placement")
+{
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    Figure_View view(ell, here, black);
+    view.rotate_cw().translate({3, -2}).flip_y();
+    auto place{view.placement()};
+    for (auto const& tile : ell.tiles())
+        CHECK(view.tiles().contains(place(tile)));
+
+    Figure_View copy(ell, here, black);
+    copy.place(place);
+    CHECK(same_tiles(copy.tiles(), view.tiles()));
+    // Subsequent transformations are about the same center.
+    CHECK(same_tiles(copy.rotate_ccw().tiles(), view.rotate_ccw().tiles()));
+}
+
+TEST_CASE("session file")
+{
+    auto file{(std::filesystem::temp_directory_path() / "4color-test.session").string()};
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    Placement moved{{0, -1, 1, 0}, {4, -2}};
+    std::vector<Session_State> states{{{Figure{}, {{}, {}}}, 0},
+                                      {{ell, {{}, moved}}, 1}};
+    write_session(file, states, 1);
+
+    Session_File session(file);
+    CHECK(session.num_states() == 2);
+    CHECK(session.now() == 1);
+    CHECK(session.num_views() == 2);
+    CHECK(session.tiles(0).empty());
+    CHECK(session.focus(1) == 1);
+    auto state{session.state(1)};
+    CHECK(state.layout.figure.tiles() == ell.tiles());
+    CHECK(state.layout.placements[1] == moved);
+
+    std::string bytes;
+    {
+        std::ifstream is{file, std::ios::binary};
+        bytes.assign(std::istreambuf_iterator<char>{is}, {});
+    }
+
+    // Rewriting the file leaves the mapped states alone.
+    write_session(file, {states.front()}, 0);
+    CHECK(session.num_states() == 2);
+    CHECK(session.state(1).layout.figure.tiles() == ell.tiles());
+    CHECK(Session_File{file}.num_states() == 1);
+
+    // Corrupt copies of the file are rejected.
+    auto check_corrupt{[&](std::string const& changed) {
+        std::ofstream{file, std::ios::binary | std::ios::trunc} << changed;
+        CHECK_THROWS(Session_File{file});
+    }};
+    auto with_count{[](std::string changed, std::size_t offset, std::uint64_t count) {
+        return changed.replace(offset, sizeof(count),
+                               reinterpret_cast<char const*>(&count), sizeof(count));
+    }};
+    // Truncated.
+    check_corrupt(bytes.substr(0, bytes.size() - 1));
+    check_corrupt(bytes.substr(0, sizeof(Session_Header) - 1));
+    // A number of tiles that wraps the expected size around to the real one.
+    check_corrupt(with_count(bytes, offsetof(Session_Header, num_tiles),
+                             4 + (std::uint64_t{1} << 61)));
+    // A state whose tiles wrap around to the start of the tile array.
+    auto record{sizeof(Session_Header) + sizeof(State_Record)};
+    auto moved_start{with_count(bytes, record + offsetof(State_Record, first_tile), 1)};
+    check_corrupt(with_count(moved_start, record + offsetof(State_Record, num_tiles),
+                             ~std::uint64_t{0}));
+    std::remove(file.c_str());
+
+    CHECK_THROWS(Session_File{file});
+}
+
+TEST_CASE("journal")
+{
+    auto file{(std::filesystem::temp_directory_path() / "4color-test.journal").string()};
+    std::remove(file.c_str());
+    CHECK(Journal::read(file).empty());
+    {
+        Journal journal(file);
+        journal.append({Edit_Type::toggle, false, {3, 4}});
+        journal.append({Edit_Type::translate, true, {-1, 0}});
+    }
+    {
+        // Re-opening appends.
+        Journal journal(file);
+        journal.append({Edit_Type::undo});
+    }
+    auto edits{Journal::read(file)};
+    REQUIRE(edits.size() == 3);
+    CHECK(edits[0].type == Edit_Type::toggle);
+    CHECK(edits[0].arg == Point{3, 4});
+    CHECK(edits[1].all);
+    CHECK(edits[2].type == Edit_Type::undo);
+    {
+        Journal journal(file);
+        journal.append({Edit_Type::focus});
+        journal.clear();
+        journal.append({Edit_Type::redo});
+    }
+    edits = Journal::read(file);
+    REQUIRE(edits.size() == 1);
+    CHECK(edits[0].type == Edit_Type::redo);
+
+    // The unused bytes of a record are written as zeros.
+    std::string bytes;
+    {
+        std::ifstream is{file, std::ios::binary};
+        bytes.assign(std::istreambuf_iterator<char>{is}, {});
+    }
+    REQUIRE(bytes.size() == 16 + 12);
+    CHECK(bytes.substr(16 + 2, 2) == std::string(2, '\0'));
+
+    // Records with an unknown type or flag are rejected.
+    auto corrupt = [&](std::size_t offset, char value) {
+        auto bad{bytes};
+        bad[16 + offset] = value;
+        std::ofstream{file, std::ios::binary} << bad;
+        return file;
+    };
+    CHECK_THROWS(Journal::read(corrupt(0, 9)));
+    CHECK_THROWS(Journal::read(corrupt(1, 2)));
+    CHECK(Journal::read(corrupt(1, 1)).front().all);
+    std::remove(file.c_str());
+}
+
+TEST_CASE("read png")
+{
+    SUBCASE("contiguous")
+    {
+        auto layout{example_layout("figure-1.png")};
+        CHECK(layout.figure.tiles().size() == 8);
+        REQUIRE(layout.placements.size() == 4);
+        CHECK(layout.placements.front() == Placement{});
+        CHECK(layout.figure.is_contiguous());
+    }
+    SUBCASE("non-contiguous")
+    {
+        auto layout{example_layout("5color-non-contiguous.png")};
+        CHECK(layout.figure.tiles().size() == 2);
+        CHECK(layout.placements.size() == 4);
+        CHECK(!layout.figure.is_contiguous());
+    }
+    SUBCASE("not a map")
+    {
+        CHECK_THROWS(example_layout("screenshot.png"));
+        // A missing color would put the copies after it on the wrong views.
+        CHECK_THROWS(example_layout("missing-color.png"));
+        CHECK_THROWS(example_layout("4-color-disks.svg"));
+    }
+}
+
+TEST_CASE("render")
+{
+    auto layout{example_layout("figure-1.png")};
+    auto frame{bounding_frame(layout.figure, layout.placements)};
+    auto w{static_cast<int>(frame.width)};
+    auto h{static_cast<int>(frame.height)};
+    Point corner{static_cast<int>(frame.origin.x), static_cast<int>(frame.origin.y)};
+    SUBCASE("pixels")
+    {
+        // At 1 pixel per tile, each tile's pixel has its view's color.
+        auto image{Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w, h)};
+        Cairo::RefPtr<Cairo::ImageSurface> pixels;
+        draw_views(Cairo::Context::create(image), layout.figure, layout.placements, frame,
+                   1.0, pixels);
+        image->flush();
+        auto data{image->get_data()};
+        auto pixel = [&](Point<int> p) {
+            auto x{p.x - corner.x};
+            auto y{h - 1 - (p.y - corner.y)};
+            auto row{data + y*image->get_stride()};
+            return reinterpret_cast<std::uint32_t const*>(row)[x];
+        };
+        std::size_t colored{0};
+        for (std::size_t i{0}; i < layout.placements.size(); ++i)
+        {
+            auto [r, g, b] = view_colors[i];
+            auto expected{0xff000000 | std::min(r, 255) << 16 | std::min(g, 255) << 8
+                          | std::min(b, 255)};
+            for (auto const& tile : layout.figure.tiles())
+            {
+                CHECK(pixel(layout.placements[i](tile)) == expected);
+                ++colored;
+            }
+        }
+        // The margin is empty.
+        CHECK(pixel(corner) == 0);
+        CHECK(colored == 32);
+
+        // The image is kept until the size changes.
+        REQUIRE(pixels);
+        auto kept{pixels};
+        draw_views(Cairo::Context::create(image), layout.figure, layout.placements, frame,
+                   1.0, pixels);
+        CHECK(pixels == kept);
+        draw_views(Cairo::Context::create(image), layout.figure, layout.placements, frame,
+                   0.5, pixels);
+        CHECK(pixels != kept);
+        CHECK(pixels->get_width() == (w + 1)/2);
+    }
+    SUBCASE("png")
+    {
+        // Write the layout and read it back.
+        auto dir{std::filesystem::temp_directory_path()};
+        auto file{(dir / "4color-render.png").string()};
+        std::vector<double> fractions;
+        write_png(file, layout.figure, layout.placements, frame, 4.0,
+                  [&fractions](double f) { fractions.push_back(f); });
+        REQUIRE(!fractions.empty());
+        CHECK(fractions.back() == doctest::Approx(1.0));
+        CHECK(std::is_sorted(fractions.begin(), fractions.end()));
+        auto read{read_png(file)};
+        REQUIRE(read.placements.size() == layout.placements.size());
+        // Tile (0, 0) of the image is the lower-left corner of the frame.
+        for (std::size_t i{0}; i < layout.placements.size(); ++i)
+        {
+            Tile_List written;
+            for (auto const& tile : layout.figure.tiles())
+                written.insert(layout.placements[i](tile) - corner);
+            Tile_List found;
+            for (auto const& tile : read.figure.tiles())
+                found.insert(read.placements[i](tile));
+            CHECK(found == written);
+        }
+        std::remove(file.c_str());
+    }
+}
+
+TEST_CASE("export queue")
+{
+    auto layout{example_layout("figure-1.png")};
+    auto frame{bounding_frame(layout.figure, layout.placements)};
+    auto dir{std::filesystem::temp_directory_path()};
+    std::vector<std::string> files{(dir / "4color-export-1.png").string(),
+                                   (dir / "4color-no-such-dir" / "export.png").string(),
+                                   (dir / "4color-export-2.png").string()};
+    std::atomic<int> notes{0};
+    {
+        Export_Queue queue([&notes] { ++notes; });
+        for (auto const& file : files)
+            queue.push({file, layout, frame, 4.0});
+        CHECK(queue.pending() <= files.size());
+        // The queue is drained before it's destroyed.
+    }
+    CHECK(notes > 0);
+    // A failed job doesn't stop the ones after it.
+    CHECK(!std::filesystem::exists(files[1]));
+    for (auto const& file : {files[0], files[2]})
+    {
+        auto read{read_png(file)};
+        CHECK(read.figure.tiles().size() == layout.figure.tiles().size());
+        CHECK(read.placements.size() == layout.placements.size());
+        std::remove(file.c_str());
+    }
+}
+
+TEST_CASE("atlas")
+{
+    auto dir{std::filesystem::temp_directory_path()};
+    auto file{(dir / "4color-atlas.png").string()};
+    std::vector<Layout> layouts(5, example_layout("figure-1.png"));
+    std::vector<std::string> files;
+    SUBCASE("one page")
+    {
+        files = write_atlas(file, layouts, {4, 16, 8, 2});
+        CHECK(files == std::vector{file});
+    }
+    SUBCASE("pages")
+    {
+        // 5 thumbnails at 2 per page.
+        files = write_atlas(file, layouts, {4, 16, 2, 2});
+        CHECK(files == std::vector{(dir / "4color-atlas-1.png").string(),
+                                   (dir / "4color-atlas-2.png").string(),
+                                   (dir / "4color-atlas-3.png").string()});
+    }
+    SUBCASE("nothing to draw")
+    {
+        CHECK(write_atlas(file, {}).empty());
+    }
+    for (auto const& page : files)
+    {
+        CHECK(std::filesystem::file_size(page) > 0);
+        std::remove(page.c_str());
+    }
+}
+
+TEST_CASE("bitboard")
+{
+    Bitboard board(70, 3);
+    board.set({64, 1});
+    board.set({100, 1});
+    CHECK(board.test({64, 1}));
+    CHECK(!board.test({63, 1}));
+    CHECK(board.count() == 1);
+    auto halo{board.halo()};
+    CHECK(halo.count() == 4);
+    CHECK(halo.test({63, 1}));
+    CHECK(halo.test({65, 1}));
+    CHECK(halo.test({64, 0}));
+    CHECK(halo.test({64, 2}));
+    CHECK(!halo.intersects(board));
+    CHECK((halo | board).count() == 5);
+    CHECK(board.shared_edges(halo) == 4);
+    CHECK(halo.shared_edges(board) == 4);
+    CHECK(halo.shared_edges(halo) == 0);
+}
+
+TEST_CASE("contact matrix")
+{
+    // A 2x2 block of squares: each touches 2 others.
+    Figure square{{0, 0}};
+    std::vector<Placement> quad{{}, {{}, {1, 0}}, {{}, {0, 1}}, {{}, {1, 1}}};
+    auto contacts{contact_matrix(square, quad)};
+    CHECK(contacts == Contact_Matrix{{0, 1, 1, 0}, {1, 0, 0, 1}, {1, 0, 0, 1}, {0, 1, 1, 0}});
+    CHECK(weakest_contact(contacts) == 0);
+    CHECK(total_contact(contacts) == 4);
+
+    auto layout{example_layout("figure-1.png")};
+    contacts = contact_matrix(layout.figure, layout.placements);
+    CHECK(weakest_contact(contacts) > 0);
+
+    // Long bars side by side across word boundaries.
+    Figure bar;
+    for (auto x{0}; x < 300; ++x)
+        bar.toggle({x, 0});
+    contacts = contact_matrix(bar, {{}, {{}, {0, 1}}, {{}, {1, 2}}});
+    CHECK(contacts[0][1] == 300);
+    CHECK(contacts[1][2] == 299);
+    CHECK(contacts[0][2] == 0);
+}
+
+TEST_CASE("holes")
+{
+    // Four bars in a pinwheel around a 2x2 hole.
+    Figure bar{{0, 0}, {1, 0}, {2, 0}};
+    std::vector<Placement> ring{{}, {orientations[1], {3, 0}}, {{}, {1, 3}},
+                                {orientations[1], {0, 1}}};
+    auto holes{find_holes(bar, ring)};
+    REQUIRE(holes.size() == 1);
+    CHECK(holes[0].tiles.size() == 4);
+    CHECK(std::ranges::count(holes[0].tiles, Point<int>{1, 1}) == 1);
+    CHECK(holes[0].copies == std::vector<std::size_t>{0, 1, 2, 3});
+
+    // Opening the ring lets the hole out.
+    ring[2].offset = {2, 3};
+    CHECK(find_holes(bar, ring).empty());
+    CHECK(find_holes(bar, {}).empty());
+
+    auto layout{example_layout("figure-1.png")};
+    CHECK(!find_holes(layout.figure, layout.placements).empty());
+
+    Search_Options options;
+    options.threads = 2;
+    auto all{collect_maps(layout.figure, options)};
+    options.hole_free = true;
+    auto open{collect_maps(layout.figure, options)};
+    // Each of this figure's maps encloses a hole.
+    REQUIRE(!all.solutions.empty());
+    CHECK(open.solutions.empty());
+    CHECK(!find_compact_map(layout.figure, options).solution);
+
+    // Three dominoes can't enclose anything.
+    Figure domino{{0, 0}, {1, 0}};
+    options.copies = 3;
+    auto threes{collect_maps(domino, options)};
+    REQUIRE(!threes.solutions.empty());
+    options.hole_free = false;
+    CHECK(collect_maps(domino, options).solutions.size() == threes.solutions.size());
+}
+
+TEST_CASE("chromatic number")
+{
+    CHECK(chromatic_number(std::vector<std::uint64_t>{}) == 0);
+    CHECK(chromatic_number(std::vector<std::uint64_t>{0, 0, 0}) == 1);
+    // A 5-cycle and a complete graph on 5 vertices.
+    CHECK(chromatic_number(std::vector<std::uint64_t>{0b10010, 0b00101, 0b01010,
+                                                      0b10100, 0b01001}) == 3);
+    CHECK(chromatic_number(std::vector<std::uint64_t>{0b11110, 0b11101, 0b11011,
+                                                      0b10111, 0b01111}) == 5);
+    // The Grötzsch graph has no triangles but needs 4 colors. Vertices 0-4 are a
+    // 5-cycle, 5-9 are each joined to the neighbors of a cycle vertex, and 10 is joined
+    // to 5-9.
+    std::vector<std::uint64_t> grotzsch(11, 0);
+    auto join{[&grotzsch](int a, int b) {
+        grotzsch[a] |= std::uint64_t{1} << b;
+        grotzsch[b] |= std::uint64_t{1} << a;
+    }};
+    for (auto i{0}; i < 5; ++i)
+    {
+        join(i, (i + 1) % 5);
+        join(i + 5, (i + 1) % 5);
+        join(i + 5, (i + 4) % 5);
+        join(i + 5, 10);
+    }
+    CHECK(chromatic_number(grotzsch) == 4);
+
+    // Four bars in a pinwheel: a 4-cycle with the hole and the outside touching all of
+    // it.
+    Figure bar{{0, 0}, {1, 0}, {2, 0}};
+    std::vector<Placement> ring{{}, {orientations[1], {3, 0}}, {{}, {1, 3}},
+                                {orientations[1], {0, 1}}};
+    auto graph{region_graph(bar, ring)};
+    CHECK(graph.copies == std::vector<std::uint64_t>{0b1010, 0b0101, 0b1010, 0b0101});
+    CHECK(graph.empty == std::vector<std::uint64_t>{0b1111, 0b1111});
+    CHECK(chromatic_number(graph) == 3);
+    auto parts{region_graph(contact_matrix(bar, ring), empty_regions(bar, ring))};
+    CHECK(parts.copies == graph.copies);
+    CHECK(parts.empty == graph.empty);
+    // Two squares side by side, and the outside.
+    CHECK(chromatic_number(region_graph(Figure{{0, 0}}, {{}, {{}, {1, 0}}})) == 3);
+    CHECK(chromatic_number(region_graph(Figure{}, ring)) == 0);
+
+    auto layout{example_layout("figure-1.png")};
+    CHECK(chromatic_number(region_graph(layout.figure, layout.placements)) == 4);
+
+    // Three copies that touch each other need a fourth color for the outside.
+    Search_Options options;
+    options.copies = 3;
+    auto all{collect_maps(layout.figure, options)};
+    options.min_colors = 4;
+    CHECK(collect_maps(layout.figure, options).solutions.size() == all.solutions.size());
+    options.min_colors = 5;
+    CHECK(collect_maps(layout.figure, options).solutions.empty());
+}
+
+TEST_CASE("canonical form")
+{
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    auto form{canonical_form(ell)};
+    for (auto const& m : orientations)
+    {
+        Placement place{m, {5, -3}};
+        Tile_List moved;
+        for (auto const& tile : ell.tiles())
+            moved.insert(place(tile));
+        CHECK(canonical_form(Figure{moved}).tiles == form.tiles);
+    }
+    for (auto const& tile : ell.tiles())
+        CHECK(std::binary_search(form.tiles.begin(), form.tiles.end(),
+                                 form.placement(tile)));
+    CHECK(symmetries(ell).size() == 1);
+    CHECK(symmetries(Figure{{0, 0}, {1, 0}}).size() == 4);
+}
+
+/// @return True if the copies don't overlap and each shares an edge with the others.
+bool is_map(Figure const& figure, Solution const& solution)
+{
+    std::vector<Tile_List> copies;
+    for (auto const& place : solution)
+    {
+        copies.emplace_back();
+        for (auto const& tile : figure.tiles())
+            copies.back().insert(place(tile));
+    }
+    auto touch{[](Tile_List const& c1, Tile_List const& c2) {
+        for (auto const& p : c1)
+            for (Point<int> d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}})
+                if (c2.contains(p + d))
+                    return true;
+        return false;
+    }};
+    for (std::size_t i{0}; i < copies.size(); ++i)
+        for (auto j{i + 1}; j < copies.size(); ++j)
+            for (auto const& p : copies[i])
+                if (copies[j].contains(p) || !touch(copies[i], copies[j]))
+                    return false;
+    return true;
+}
+
+TEST_CASE("find maps")
+{
+    auto layout{example_layout("figure-1.png")};
+    std::mutex mutex;
+    std::vector<Solution> solutions;
+    auto stats{find_maps(layout.figure, [&](unsigned, Solution const& solution) {
+        std::lock_guard lock{mutex};
+        solutions.push_back(solution);
+    })};
+    CHECK(stats.complete());
+    CHECK(stats.fraction == 1.0);
+    CHECK(stats.nodes > 0);
+    auto n{stats.solutions};
+    CHECK(n == solutions.size());
+    REQUIRE(!solutions.empty());
+    for (auto const& solution : solutions)
+        CHECK(is_map(layout.figure, solution));
+
+    // Not unique, each map is found once for each copy that can be the unmoved one.
+    auto all{find_maps(layout.figure, [](unsigned, Solution const&) {},
+                       {4, 0, false})};
+    CHECK(all.solutions >= 4*n);
+
+    // A domino can't make a 4-color map.
+    CHECK(collect_maps(Figure{{0, 0}, {1, 0}}).solutions.empty());
+}
+
+TEST_CASE("search limits")
+{
+    auto figure{example_layout("figure-1.png").figure};
+    SUBCASE("stop")
+    {
+        std::stop_source stop;
+        stop.request_stop();
+        auto result{collect_maps(figure, {4, 0, true, {stop.get_token()}})};
+        CHECK(result.stats.end == Search_End::stopped);
+        CHECK(result.solutions.empty());
+    }
+    SUBCASE("budget")
+    {
+        auto result{collect_maps(figure, {4, 1, false, {{}, Search_Clock::time_point::max(),
+                                                        1}})};
+        CHECK(result.stats.end == Search_End::budget);
+        CHECK(result.stats.fraction < 1.0);
+        // The budget is checked every so many nodes.
+        CHECK(result.stats.nodes <= Search_Control::check_interval);
+        CHECK(result.solutions.size() == result.stats.solutions);
+    }
+    SUBCASE("deadline")
+    {
+        auto result{collect_maps(figure, {4, 0, true,
+                                          Search_Limits::within(std::chrono::seconds{-1})})};
+        CHECK(result.stats.end == Search_End::deadline);
+        CHECK(result.solutions.empty());
+    }
+    SUBCASE("no limits")
+    {
+        auto result{collect_maps(figure, {4, 0, true,
+                                          Search_Limits::within(std::chrono::hours{1})})};
+        CHECK(result.stats.complete());
+        CHECK(!result.solutions.empty());
+    }
+    SUBCASE("setup")
+    {
+        // Finding the placements of a big figure takes seconds. The limits are checked
+        // while that's done.
+        Tile_List tiles;
+        for (auto i{0}; i < 80; ++i)
+        {
+            tiles.insert({i, 0});
+            tiles.insert({0, i});
+        }
+        Figure ell{tiles};
+        auto limits = [] { return Search_Limits::within(std::chrono::milliseconds{50}); };
+        auto start{Search_Clock::now()};
+        CHECK(find_maps(ell, {}, {4, 0, true, limits()}).end == Search_End::deadline);
+        CHECK(Search_Clock::now() - start < std::chrono::seconds{1});
+        start = Search_Clock::now();
+        auto compact{find_compact_map(ell, {4, 0, true, limits()})};
+        CHECK(compact.stats.end == Search_End::deadline);
+        CHECK(Search_Clock::now() - start < std::chrono::seconds{1});
+    }
+}
+
+TEST_CASE("solution writer")
+{
+    auto file{(std::filesystem::temp_directory_path() / "4color-test.solutions").string()};
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    Solution solution{{}, {{0, -1, 1, 0}, {4, -2}}};
+    auto shape{canonical_form(ell)};
+    SUBCASE("ndjson")
+    {
+        {
+            Solution_Writer writer(file, {Solution_Format::ndjson});
+            writer.write(0, shape, solution);
+            writer.write(0, shape, solution);
+        }
+        std::ifstream is{file};
+        std::string line;
+        std::getline(is, line);
+        CHECK(line.starts_with("{\"tiles\":[[0,0],[0,1],[0,2],[1,0]],\"views\":[["));
+        std::getline(is, line);
+        CHECK(!line.empty());
+        CHECK(!std::getline(is, line));
+    }
+    for (auto compression : {Compression::none, Compression::gzip})
+    {
+        CAPTURE(compression);
+        {
+            // A small block size makes several compressed blocks.
+            Solution_Writer writer(file, {Solution_Format::binary, compression, 2, 64, 2});
+            for (auto i{0}; i < 10; ++i)
+                writer.write(i % 2, shape, solution);
+        }
+        auto records{read_solutions(file)};
+        REQUIRE(records.size() == 10);
+        CHECK(records[0].tiles == shape.tiles);
+        REQUIRE(records[0].placements.size() == 2);
+        // The record's placements put the canonical tiles where the solution puts the
+        // figure's, moved to the canonical frame.
+        CHECK(records[9].placements[0] == Placement{});
+        for (auto const& tile : ell.tiles())
+            CHECK(records[9].placements[1](shape.placement(tile))
+                  == shape.placement(solution[1](tile)));
+    }
+    CHECK_THROWS(Solution_Writer(file, {Solution_Format::binary, Compression::none, 1,
+                                        64, 3}).write(0, shape, solution));
+    SUBCASE("errors")
+    {
+        {
+            // A rejected solution leaves nothing behind in the buffer.
+            Solution_Writer writer(file, {Solution_Format::binary, Compression::none, 1,
+                                          64, 2});
+            writer.write(0, shape, solution);
+            CHECK_THROWS(writer.write(0, shape, {{}, {{}, {40000, 0}}}));
+            writer.write(0, shape, solution);
+        }
+        auto records{read_solutions(file)};
+        REQUIRE(records.size() == 2);
+        CHECK(records[1].tiles == shape.tiles);
+
+        // An error in a search thread ends the search and is passed to the caller.
+        Figure bar{{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}};
+        Solution_Writer writer(file, {Solution_Format::binary, Compression::none, 2, 64,
+                                      2, 4});
+        Search_Options options;
+        options.copies = 2;
+        options.threads = 2;
+        CHECK_THROWS_AS(find_maps(bar, writer.handler(bar), options), std::runtime_error);
+    }
+    std::remove(file.c_str());
+}
+
+TEST_CASE("catalog")
+{
+    auto file{(std::filesystem::temp_directory_path() / "4color-test.catalog").string()};
+    write_catalog(file, 8);
+    Catalog catalog(file);
+    CHECK(catalog.max_size() == 8);
+    // The numbers of free polyominoes.
+    std::vector<std::size_t> counts{0, 1, 1, 2, 5, 12, 35, 108, 369};
+    for (auto n{1}; n <= 8; ++n)
+        CHECK(catalog.count(n) == counts[n]);
+    CHECK(catalog.count(9) == 0);
+
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    auto k{catalog.find(ell)};
+    REQUIRE(k);
+    CHECK(catalog.tiles(4, *k) == canonical_form(ell).tiles);
+    CHECK(catalog.bitboard(4, *k).count() == 4);
+    for (std::size_t i{0}; i < catalog.count(7); ++i)
+        CHECK(catalog.find(catalog.figure(7, i)) == i);
+    CHECK(!catalog.find(Figure{{0, 0}, {2, 0}}));
+    std::remove(file.c_str());
+
+    CHECK_THROWS(write_catalog(file, 17));
+}
+
+TEST_CASE("solution cache")
+{
+    auto file{(std::filesystem::temp_directory_path() / "4color-test.cache").string()};
+    std::remove(file.c_str());
+    Figure ell{{1, 1}, {1, 2}, {1, 3}, {2, 1}};
+    Figure turned{{0, 0}, {-1, 0}, {-2, 0}, {0, 1}};
+    Solution solution{{}, {{0, -1, 1, 0}, {4, -2}}};
+    {
+        Solution_Cache cache(file);
+        CHECK(!cache.count(ell));
+        cache.store(ell, 7, {solution});
+        CHECK(cache.count(ell) == 7);
+    }
+    {
+        // Another instance sees the entry, and a copy of the figure finds it.
+        Solution_Cache cache(file);
+        auto result{cache.find(turned)};
+        REQUIRE(result);
+        CHECK(result->count == 7);
+        REQUIRE(result->solutions.size() == 1);
+        CHECK(result->solutions[0][0] == Placement{});
+        // Find a placement T such that turned = T(ell) and check that the cached
+        // solution has the same copies.
+        auto T{*find_placement(ell, {turned.tiles().begin(), turned.tiles().end()})};
+        for (auto const& tile : ell.tiles())
+            CHECK(result->solutions[0][1](T(tile)) == T(solution[1](tile)));
+    }
+    std::remove(file.c_str());
+
+    SUBCASE("least recently used")
+    {
+        Solution_Cache cache(file, {4, 1 << 20, 16});
+        std::vector<Figure> bars;
+        for (auto n{1}; n <= 6; ++n)
+        {
+            Tile_List tiles;
+            for (auto x{0}; x < n; ++x)
+                tiles.insert({x, 0});
+            bars.emplace_back(tiles);
+        }
+        for (auto i{0}; i < 4; ++i)
+            cache.store(bars[i], i, {});
+        CHECK(cache.size() == 4);
+        // Use the first, then add more. The others go first.
+        CHECK(cache.find(bars[0]));
+        cache.store(bars[4], 4, {});
+        cache.store(bars[5], 5, {});
+        CHECK(cache.count(bars[0]) == 0);
+        CHECK(cache.count(bars[5]) == 5);
+        CHECK(!cache.count(bars[1]));
+        CHECK(cache.size() <= 4);
+        std::remove(file.c_str());
+    }
+    SUBCASE("replace")
+    {
+        Solution_Cache cache(file, {4, 1 << 20, 2});
+        CHECK(cache.max_solutions() == 2);
+        Figure bar{{0, 0}, {1, 0}};
+        cache.store(bar, 1, {});
+        cache.store(ell, 1, {});
+        // Only max_solutions are kept.
+        cache.store(ell, 3, {solution, solution, solution});
+        CHECK(cache.size() == 2);
+        CHECK(cache.count(bar) == 1);
+        CHECK(cache.find(ell)->solutions.size() == 2);
+        // A smaller entry goes in the old one's place.
+        cache.store(ell, 2, {});
+        CHECK(cache.size() == 2);
+        CHECK(cache.count(bar) == 1);
+        CHECK(cache.count(ell) == 2);
+        CHECK(cache.find(ell)->solutions.empty());
+        std::remove(file.c_str());
+    }
+    SUBCASE("live solver")
+    {
+        // The live solver stores the results of searches that finish.
+        Solution_Cache cache(file, {4, 1 << 20, 2});
+        {
+            Live_Solver solver({}, &cache);
+            auto generation{solver.solve(ell)};
+            while (!(solver.status().generation == generation && solver.status().done))
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        CHECK(cache.count(ell) == collect_maps(ell).stats.solutions);
+        CHECK(cache.find(ell)->solutions.size() <= 2);
+
+        // A search may finish before it's stopped, but a partial count isn't stored.
+        auto figure{example_layout("figure-13-1.png").figure};
+        {
+            Live_Solver solver({}, &cache);
+            solver.solve(figure);
+        }
+        auto count{cache.count(figure)};
+        CHECK((!count || *count == collect_maps(figure).stats.solutions));
+        std::remove(file.c_str());
+    }
+}
+
+TEST_CASE("live solver")
+{
+    auto figure{example_layout("figure-1.png").figure};
+    auto expected{collect_maps(figure).stats.solutions};
+    std::atomic<int> notes{0};
+    Live_Solver solver([&notes] { ++notes; });
+    // The first search is dropped for the second.
+    solver.solve(Figure{{0, 0}, {1, 0}, {2, 0}, {1, 1}});
+    auto generation{solver.solve(figure)};
+    while (!(solver.status().generation == generation && solver.status().done))
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    CHECK(solver.status().found == expected);
+    CHECK(solver.status().percent == 100);
+    auto solutions{solver.take()};
+    CHECK(solutions.size() == expected);
+    for (auto const& solution : solutions)
+        CHECK(is_map(figure, solution));
+    CHECK(solver.take().empty());
+    CHECK(notes > 0);
+
+    Live_Solver triples({}, nullptr, 3);
+    generation = triples.solve(figure);
+    while (!(triples.status().generation == generation && triples.status().done))
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    solutions = triples.take();
+    REQUIRE(!solutions.empty());
+    CHECK(solutions.front().size() == 3);
+
+    std::atomic_flag called;
+    auto all{find_maps(figure, [](unsigned, Solution const&) {},
+                       {4, 1, false, {}, [&called](double) { called.test_and_set(); }})};
+    CHECK(all.solutions > 0);
+    CHECK(called.test());
+}
+
+TEST_CASE("spsc queue")
+{
+    Spsc_Queue<int> queue(3);
+    for (auto i{0}; i < 4; ++i)
+        CHECK(queue.push(i));
+    CHECK(!queue.push(4));
+    CHECK(queue.pop() == 0);
+    CHECK(queue.push(4));
+    for (auto i{1}; i <= 4; ++i)
+        CHECK(queue.pop() == i);
+    CHECK(!queue.pop());
+}
+
+TEST_CASE("move hints")
+{
+    auto layout{example_layout("figure-1.png")};
+    auto tiles_of{[&layout](Placement const& place) {
+        Tile_List tiles;
+        for (auto const& tile : layout.figure.tiles())
+            tiles.insert(place(tile));
+        return tiles;
+    }};
+    for (std::size_t focus{0}; focus < layout.placements.size(); ++focus)
+    {
+        auto hints{evaluate_moves(layout, focus)};
+        REQUIRE(hints.size() == 7);
+        for (auto const& hint : hints)
+        {
+            // Check against the view's own transformation and a tile-by-tile count.
+            auto figure{layout.figure};
+            Figure_View view(figure, here, black);
+            view.place(layout.placements[focus]);
+            if (hint.move.type == Edit_Type::translate)
+                view.translate(hint.move.arg);
+            else if (hint.move.type == Edit_Type::rotate_ccw)
+                view.rotate_ccw();
+            else if (hint.move.type == Edit_Type::rotate_cw)
+                view.rotate_cw();
+            else
+                view.flip_y();
+            auto moved{view.tiles()};
+            CHECK(tiles_of(hint.placement) == moved);
+
+            std::size_t touches{0};
+            auto overlaps{false};
+            for (std::size_t v{0}; v < layout.placements.size(); ++v)
+            {
+                if (v == focus)
+                    continue;
+                auto other{tiles_of(layout.placements[v])};
+                auto touch{false};
+                for (auto const& p : moved)
+                {
+                    overlaps = overlaps || other.contains(p);
+                    for (Point<int> d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}})
+                        touch = touch
+                            || (other.contains(p + d) && !moved.contains(p + d));
+                }
+                touches += touch;
+            }
+            CHECK(hint.touches == touches);
+            CHECK(hint.overlaps == overlaps);
+        }
+    }
+
+    std::atomic<int> notes{0};
+    Move_Hinter hinter([&notes] { ++notes; });
+    auto generation{hinter.request(layout, 0)};
+    while (!hinter.hints(generation))
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    CHECK(hinter.hints(generation)->size() == 7);
+    CHECK(notes > 0);
+}
+
+TEST_CASE("snap to map")
+{
+    auto layout{example_layout("figure-1.png")};
+    auto snapped{snap_to_map(layout)};
+    CHECK(snapped.found);
+    CHECK(snapped.moves.empty());
+    CHECK(snapped.placements == layout.placements);
+
+    // Knock two views out of place.
+    auto figure{layout.figure};
+    Figure_View view(figure, here, black);
+    layout.placements[1].offset += Point{3, 0};
+    view.place(layout.placements[2]);
+    layout.placements[2] = view.rotate_cw().placement();
+    snapped = snap_to_map(layout);
+    REQUIRE(snapped.found);
+    CHECK(snapped.moves.size() <= 4);
+    CHECK(snapped.stats.complete());
+    CHECK(is_map(layout.figure, snapped.placements));
+
+    // Replaying the moves gives the same placements.
+    auto places{layout.placements};
+    for (auto const& move : snapped.moves)
+    {
+        view.place(places[move.view]);
+        make_move(view, move.move);
+        places[move.view] = view.placement();
+    }
+    CHECK(places == snapped.placements);
+
+    Search_Limits limits;
+    limits.node_budget = 1;
+    layout.placements[1].offset += Point{10, 10};
+    snapped = snap_to_map(layout, limits);
+    CHECK(!snapped.found);
+    CHECK(snapped.stats.end == Search_End::budget);
+
+    SUBCASE("big figure")
+    {
+        // The contact table of a big figure is capped, and the limits are checked while
+        // it's built.
+        Tile_List tiles;
+        for (auto i{0}; i < 80; ++i)
+        {
+            tiles.insert({i, 0});
+            tiles.insert({0, i});
+        }
+        Layout ell{Figure{tiles}, {}};
+        for (auto i{0}; i < 4; ++i)
+            ell.placements.push_back({{}, {200*i, 0}});
+        auto start{Search_Clock::now()};
+        snapped = snap_to_map(ell, Search_Limits::within(std::chrono::milliseconds{50}));
+        CHECK(!snapped.found);
+        CHECK(snapped.stats.end == Search_End::deadline);
+        CHECK(Search_Clock::now() - start < std::chrono::seconds{1});
+    }
+    SUBCASE("snapper")
+    {
+        std::atomic<int> notes{0};
+        Snapper snapper{[&notes] { ++notes; }};
+        // A newer request supersedes an older one.
+        auto first{snapper.request(layout, {})};
+        layout.placements[1].offset -= Point{10, 10};
+        auto second{snapper.request(layout, {})};
+        CHECK(second > first);
+        while (!snapper.result(second))
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        CHECK(!snapper.result(first));
+        auto expected{snap_to_map(layout)};
+        auto result{*snapper.result(second)};
+        CHECK(result.found == expected.found);
+        CHECK(result.placements == expected.placements);
+        CHECK(notes > 0);
+    }
+}
+
+TEST_CASE("anneal")
+{
+    auto layout{example_layout("figure-1.png")};
+    CHECK(layout_cost(layout) == 0);
+    auto stray{layout};
+    stray.figure.toggle({100, 100});
+    CHECK(layout_cost(stray) >= stray.placements.size());
+    CHECK(layout_cost({stray.figure, {}}) == 0);
+
+    layout.placements[1].offset += Point{6, 3};
+    layout.placements[2].offset += Point{-5, 4};
+    layout.placements[3].offset += Point{2, -7};
+    CHECK(layout_cost(layout) > 0);
+
+    // One chain is repeatable.
+    Anneal_Options options;
+    options.threads = 1;
+    options.limits.node_budget = 200000;
+    auto result{anneal(layout, options)};
+    CHECK(result.cost == layout_cost(result.best));
+    CHECK(result.cost == 0);
+    CHECK(result.stats.complete());
+    CHECK(result.best.figure.tiles().size() == layout.figure.tiles().size());
+    CHECK(result.best.figure.is_contiguous());
+    CHECK(is_map(result.best.figure, result.best.placements));
+
+    options.threads = 2;
+    options.limits.node_budget = 1000;
+    result = anneal(layout, options);
+    CHECK(result.cost == layout_cost(result.best));
+    CHECK(result.cost <= layout_cost(layout));
+}
+
+TEST_CASE("exact cover")
+{
+    auto covers{[](Figure const& figure, Tile_List const& region, bool contacts) {
+        std::mutex mutex;
+        std::vector<Solution> solutions;
+        Cover_Options options;
+        options.threads = 2;
+        options.require_contacts = contacts;
+        auto stats{find_covers(figure, region, [&](unsigned, Solution const& solution) {
+            std::lock_guard lock{mutex};
+            solutions.push_back(solution);
+        }, options)};
+        CHECK(stats.complete());
+        CHECK(stats.solutions == solutions.size());
+        return solutions;
+    }};
+
+    // There are 5 domino tilings of a 2x4 rectangle.
+    Figure domino{{0, 0}, {1, 0}};
+    auto region{rectangle({0, 0}, {3, 1})};
+    auto all{covers(domino, region, false)};
+    CHECK(all.size() == 5);
+    std::size_t maps{0};
+    for (auto const& solution : all)
+    {
+        REQUIRE(solution.size() == 4);
+        Tile_List covered;
+        for (auto const& place : solution)
+            for (auto const& t : domino.tiles())
+                covered.insert(place(t));
+        CHECK(covered == region);
+        maps += is_map(domino, solution);
+    }
+    auto touching{covers(domino, region, true)};
+    CHECK(touching.size() == maps);
+    for (auto const& solution : touching)
+        CHECK(is_map(domino, solution));
+
+    // The region must hold a whole number of copies.
+    CHECK(covers(domino, rectangle({0, 0}, {2, 0}), false).empty());
+
+    // The tiles of a map can be filled with the same map.
+    auto layout{example_layout("figure-1.png")};
+    auto copies{[&layout](Solution const& solution) {
+        std::set<Tile_List> tiles;
+        for (auto const& place : solution)
+        {
+            Tile_List copy;
+            for (auto const& t : layout.figure.tiles())
+                copy.insert(place(t));
+            tiles.insert(copy);
+        }
+        return tiles;
+    }};
+    region.clear();
+    for (auto const& copy : copies(layout.placements))
+        region.insert(copy.begin(), copy.end());
+    auto found{false};
+    for (auto const& solution : covers(layout.figure, region, true))
+    {
+        CHECK(is_map(layout.figure, solution));
+        found = found || copies(solution) == copies(layout.placements);
+    }
+    CHECK(found);
+}
+
+TEST_CASE("sat solver")
+{
+    Cnf cnf;
+    auto a{cnf.add_variable()};
+    auto b{cnf.add_variable()};
+    cnf.add({a, b});
+    cnf.add({-a, b});
+    cnf.add({a, -b});
+    std::ostringstream os;
+    write_dimacs(os, cnf);
+    CHECK(os.str() == "p cnf 2 3\n1 2 0\n-1 2 0\n1 -2 0\n");
+
+    Sat_Solver solver;
+    solver.add(cnf);
+    CHECK(solver.solve() == Sat_Result::satisfiable);
+    CHECK(solver.value(a));
+    CHECK(solver.value(b));
+    CHECK(solver.stats().solutions == 1);
+    solver.add_clause({-a, -b});
+    CHECK(solver.solve() == Sat_Result::unsatisfiable);
+    CHECK(solver.stats().complete());
+
+    // 7 pigeons don't fit in 6 holes, but it takes a while to find out.
+    auto pigeonholes{[](int holes) {
+        Cnf cnf;
+        for (auto i{0}; i <= holes; ++i)
+        {
+            std::vector<int> clause;
+            for (auto j{0}; j < holes; ++j)
+                clause.push_back(i*holes + j + 1);
+            cnf.add(clause);
+        }
+        for (auto j{0}; j < holes; ++j)
+            for (auto i1{0}; i1 <= holes; ++i1)
+                for (auto i2{i1 + 1}; i2 <= holes; ++i2)
+                    cnf.add({-(i1*holes + j + 1), -(i2*holes + j + 1)});
+        return cnf;
+    }};
+    Sat_Solver pigeons;
+    pigeons.add(pigeonholes(6));
+    Search_Limits limits;
+    limits.node_budget = 10;
+    CHECK(pigeons.solve(limits) == Sat_Result::unknown);
+    CHECK(pigeons.stats().end == Search_End::budget);
+    CHECK(pigeons.solve() == Sat_Result::unsatisfiable);
+}
+
+TEST_CASE("sat map")
+{
+    // The figure is found along with its map.
+    Sat_Map_Options options;
+    options.tiles = 2;
+    options.copies = 3;
+    auto result{find_map_sat(options)};
+    REQUIRE(result.layout);
+    CHECK(result.stats.complete());
+    CHECK(result.layout->figure.tiles().size() == 2);
+    CHECK(result.layout->figure.is_contiguous());
+    CHECK(result.layout->placements.size() == 3);
+    CHECK(is_map(result.layout->figure, result.layout->placements));
+
+    // Grid squares can't touch in threes.
+    options.tiles = 1;
+    result = find_map_sat(options);
+    CHECK(!result.layout);
+    CHECK(result.stats.complete());
+
+    // Nor can four dominoes all touch each other, but four copies of a figure in pieces
+    // can.
+    options.tiles = 2;
+    options.copies = 4;
+    result = find_map_sat(options);
+    CHECK(!result.layout);
+    CHECK(result.stats.complete());
+    options.contiguous = false;
+    options.box = 3;
+    result = find_map_sat(options);
+    REQUIRE(result.layout);
+    CHECK(!result.layout->figure.is_contiguous());
+    CHECK(result.layout->placements.size() == 4);
+    CHECK(is_map(result.layout->figure, result.layout->placements));
+
+    // The solver's model decodes to a map: the cells that are set make the figure, and
+    // each copy has one placement that's set.
+    options.box = 0;
+    options.copies = 3;
+    options.figure = Figure{{0, 0}, {1, 0}, {1, 1}};
+    auto model{encode_map(options)};
+    Sat_Solver solver;
+    solver.add(model.cnf);
+    REQUIRE(solver.solve() == Sat_Result::satisfiable);
+    Tile_List tiles;
+    for (auto const& [p, v] : model.cells)
+        if (solver.value(v))
+            tiles.insert(p);
+    CHECK(tiles == options.figure->tiles());
+    Solution decoded{Placement{}};
+    for (auto const& placements : model.placements)
+        for (auto const& [place, v] : placements)
+            if (solver.value(v))
+                decoded.push_back(place);
+    CHECK(decoded.size() == 3);
+    CHECK(is_map(*options.figure, decoded));
+    options.contiguous = true;
+
+    // A given figure keeps its frame.
+    options.copies = 3;
+    options.figure = Figure{{5, 5}, {6, 5}, {6, 6}, {6, 7}};
+    result = find_map_sat(options);
+    REQUIRE(result.layout);
+    CHECK(result.layout->figure.tiles() == options.figure->tiles());
+    CHECK(result.layout->placements.front() == Placement{});
+    CHECK(is_map(result.layout->figure, result.layout->placements));
+
+    // There is a variable for each cell of the box and each placement of a copy.
+    options.figure.reset();
+    options.tiles = 4;
+    options.box = 3;
+    auto encoding{encode_map(options)};
+    CHECK(encoding.cells.size() == 9);
+    CHECK(encoding.placements.size() == 2);
+    CHECK(encoding.placements.front().size() == 8*7*7);
+}
+
+TEST_CASE("joint search")
+{
+    // Three dominoes can touch each other, but three squares can't.
+    Joint_Options options;
+    options.copies = 3;
+    auto result{smallest_map(options)};
+    REQUIRE(result.layout);
+    CHECK(result.stats.complete());
+    CHECK(result.layout->figure.tiles().size() == 2);
+    CHECK(is_map(result.layout->figure, result.layout->placements));
+
+    // The figures grown with maps are the ones that a search finds maps for.
+    std::set<std::uint64_t> grown;
+    auto stats{grow_maps(3, [&grown](Layout const& layout) {
+        CHECK(layout.figure.is_contiguous());
+        CHECK(is_map(layout.figure, layout.placements));
+        grown.insert(canonical_hash(layout.figure));
+    }, options)};
+    CHECK(stats.complete());
+    CHECK(stats.solutions >= grown.size());
+    std::set<std::uint64_t> searched;
+    Search_Options search_options;
+    search_options.copies = 3;
+    for (auto const& figure : {Figure{{0, 0}, {1, 0}, {2, 0}}, Figure{{0, 0}, {1, 0}, {0, 1}}})
+        if (!collect_maps(figure, search_options).solutions.empty())
+            searched.insert(canonical_hash(figure));
+    CHECK(!grown.empty());
+    CHECK(grown == searched);
+
+    // No figure of 4 tiles has a map.
+    options.copies = 4;
+    options.max_tiles = 4;
+    result = smallest_map(options);
+    CHECK(!result.layout);
+    CHECK(result.stats.complete());
+
+    // The same holds for 4 copies of 8 tiles, where some figures have maps only with the
+    // second copy touching the unmoved one at a different tile.
+    grown.clear();
+    stats = grow_maps(8, [&grown](Layout const& layout) {
+        CHECK(is_map(layout.figure, layout.placements));
+        grown.insert(canonical_hash(layout.figure));
+    }, options);
+    CHECK(stats.complete());
+    auto file{(std::filesystem::temp_directory_path() / "4color-test-joint.catalog").string()};
+    write_catalog(file, 8);
+    Catalog catalog(file);
+    searched.clear();
+    search_options.copies = 4;
+    for (std::size_t k{0}; k < catalog.count(8); ++k)
+        if (auto figure{catalog.figure(8, k)};
+            !collect_maps(figure, search_options).solutions.empty())
+            searched.insert(canonical_hash(figure));
+    std::remove(file.c_str());
+    CHECK(grown == searched);
+    Figure cup{{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 4}, {2, 0}};
+    CHECK(grown.count(canonical_hash(cup)) == 1);
+}
+
+TEST_CASE("compact map")
+{
+    auto layout{example_layout("figure-1.png")};
+    Search_Options options;
+    options.threads = 2;
+    auto all{collect_maps(layout.figure, options)};
+    REQUIRE(!all.solutions.empty());
+    auto smallest{map_area(layout.figure, all.solutions.front())};
+    for (auto const& solution : all.solutions)
+        smallest = std::min(smallest, map_area(layout.figure, solution));
+
+    auto result{find_compact_map(layout.figure, options)};
+    REQUIRE(result.solution);
+    CHECK(result.stats.complete());
+    CHECK(result.area == smallest);
+    CHECK(map_area(layout.figure, *result.solution) == smallest);
+    CHECK(is_map(layout.figure, *result.solution));
+    // Pruning visits fewer placements than finding all the maps.
+    CHECK(result.stats.nodes < all.stats.nodes);
+
+    // Dominoes have no map.
+    CHECK(!find_compact_map(Figure{{0, 0}, {1, 0}}, options).solution);
+}
+
+TEST_CASE("top maps")
+{
+    auto layout{example_layout("figure-1.png")};
+    Search_Options options;
+    options.threads = 2;
+    auto all{collect_maps(layout.figure, options)};
+    REQUIRE(all.solutions.size() > 3);
+    std::vector<double> scores;
+    for (auto const& solution : all.solutions)
+        scores.push_back(shared_edges(layout.figure, solution));
+    std::sort(scores.rbegin(), scores.rend());
+
+    auto ranking{top_maps(layout.figure, 3, shared_edges, options)};
+    CHECK(ranking.stats.complete());
+    CHECK(ranking.stats.solutions == all.solutions.size());
+    REQUIRE(ranking.maps.size() == 3);
+    for (std::size_t i{0}; i < 3; ++i)
+    {
+        CHECK(ranking.maps[i].score == scores[i]);
+        CHECK(shared_edges(layout.figure, ranking.maps[i].solution) == scores[i]);
+        CHECK(is_map(layout.figure, ranking.maps[i].solution));
+    }
+
+    auto compact{top_maps(layout.figure, 1, compactness, options)};
+    REQUIRE(compact.maps.size() == 1);
+    CHECK(-compact.maps.front().score
+          == find_compact_map(layout.figure, options).area);
+    CHECK(top_maps(layout.figure, 0, symmetry, options).maps.empty());
+
+    // A square of 4 squares is symmetric.
+    Figure square{{0, 0}};
+    Solution quad{{}, {{}, {1, 0}}, {{}, {0, 1}}, {{}, {1, 1}}};
+    CHECK(symmetry(square, quad) == 8);
+    CHECK(shared_edges(square, quad) == 4);
+    CHECK(symmetry(layout.figure, layout.placements) >= 1);
+
+    // The pinwheel of bars encloses a 2x2 hole.
+    Figure bar{{0, 0}, {1, 0}, {2, 0}};
+    Solution ring{{}, {orientations[1], {3, 0}}, {{}, {1, 3}}, {orientations[1], {0, 1}}};
+    CHECK(openness(bar, ring) == -4);
+    CHECK(openness(square, quad) == 0);
+    auto open{top_maps(layout.figure, 1, openness, options)};
+    REQUIRE(open.maps.size() == 1);
+    options.hole_free = true;
+    auto hole_free{collect_maps(layout.figure, options)};
+    CHECK((open.maps.front().score == 0) == !hole_free.solutions.empty());
+    CHECK(openness(layout.figure, open.maps.front().solution) == open.maps.front().score);
+}
+
+TEST_CASE("colorful maps")
+{
+    // Two tiles a knight's move, a diagonal step, a step of 2, or a diagonal step of 2
+    // apart.
+    CHECK(scattered_figures(2, 3).size() == 4);
+    CHECK(scattered_figures(1, 3).empty());
+    for (auto const& figure : scattered_figures(3, 3))
+        CHECK(canonical_form(figure).tiles.front() == *figure.tiles().begin());
+
+    // The README's 5-color map is made from a figure with two tiles a knight's move apart.
+    auto example{example_layout("5color-non-contiguous.png")};
+    REQUIRE(example.placements.size() == 4);
+    CHECK(chromatic_number(region_graph(example.figure, example.placements)) == 5);
+
+    std::mutex mutex;
+    std::vector<Layout> layouts;
+    Color_Search_Options options;
+    options.threads = 2;
+    auto stats{find_colorful_maps([&](Layout const& layout) {
+        std::lock_guard lock{mutex};
+        layouts.push_back(layout);
+    }, options)};
+    CHECK(stats.complete());
+    CHECK(stats.fraction == 1.0);
+    CHECK(stats.solutions == layouts.size());
+    auto knight{canonical_form(example.figure).tiles};
+    CHECK(std::ranges::any_of(layouts, [&knight](auto const& layout) {
+        return canonical_form(layout.figure).tiles == knight;
+    }));
+    for (auto const& layout : layouts)
+    {
+        CHECK(chromatic_number(region_graph(layout.figure, layout.placements)) >= 5);
+        CHECK(is_map(layout.figure, layout.placements));
+    }
+
+    // A node budget ends the search early.
+    options.limits.node_budget = 1;
+    CHECK(find_colorful_maps([](Layout const&) {}, options).end == Search_End::budget);
+}